@@ -0,0 +1,148 @@
+/*
+ * Arena.cc
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Arena.h"
+#include <cstddef>
+#include <new>
+#include <sys/mman.h>
+
+namespace {
+
+class HeapResource : public MemoryResource {
+public:
+    void * Allocate(size_t bytes, size_t alignment) {
+        assert(alignment <= alignof(max_align_t));
+        return ::operator new(bytes);
+    }
+
+    void Deallocate(void *p, size_t, size_t) {
+        ::operator delete(p);
+    }
+};
+
+}
+
+/*static*/MemoryResource * MemoryResource::Heap() {
+    // Never destroyed, so that containers in other static objects can outlive it.
+    static HeapResource *heap = new HeapResource();
+    return heap;
+}
+
+// The block header keeps the data after it at max_align_t alignment.
+static const size_t HEADER_SIZE = (sizeof(void *) + sizeof(size_t) + alignof(max_align_t) - 1)
+        / alignof(max_align_t) * alignof(max_align_t);
+
+Arena::Arena(size_t blockSize, MemoryResource *upstream)
+        : upstream(upstream != NULL ? upstream : MemoryResource::Heap()), blocks(NULL), cursor(NULL), end(NULL),
+          firstBlockSize(max(blockSize, 2 * HEADER_SIZE)), nextBlockSize(firstBlockSize), bytesReserved(0) {
+}
+
+Arena::~Arena() {
+    Release();
+}
+
+void * Arena::Allocate(size_t bytes, size_t alignment) {
+    assert(alignment > 0 && alignment <= alignof(max_align_t) && (alignment & (alignment - 1)) == 0);
+    char *p = (char *) (((uintptr_t) cursor + alignment - 1) & ~(uintptr_t) (alignment - 1));
+    if (cursor == NULL || p + bytes > end) {
+        NewBlock(max(nextBlockSize, HEADER_SIZE + bytes));
+        p = cursor;
+    }
+    cursor = p + bytes;
+    return p;
+}
+
+void Arena::Release() {
+    FreeBlocks();
+    nextBlockSize = firstBlockSize;
+}
+
+void Arena::Reset() {
+    if (blocks == NULL) {
+        return;
+    }
+    if (blocks->previous == NULL) {
+        cursor = (char *) blocks + HEADER_SIZE;
+        return;
+    }
+    const size_t size = bytesReserved;
+    FreeBlocks();
+    NewBlock(size);
+}
+
+void Arena::NewBlock(size_t size) {
+    Block *block = (Block *) upstream->Allocate(size, alignof(max_align_t));
+    block->previous = blocks;
+    block->size = size;
+    blocks = block;
+    bytesReserved += size;
+    nextBlockSize = 2 * size;
+    cursor = (char *) block + HEADER_SIZE;
+    end = (char *) block + size;
+}
+
+void Arena::FreeBlocks() {
+    while (blocks != NULL) {
+        Block *previous = blocks->previous;
+        upstream->Deallocate(blocks, blocks->size, alignof(max_align_t));
+        blocks = previous;
+    }
+    bytesReserved = 0;
+    cursor = NULL;
+    end = NULL;
+}
+
+HugePageResource::HugePageResource(size_t minBytes, MemoryResource *upstream)
+        : minBytes(max((size_t) 1, minBytes)), upstream(upstream != NULL ? upstream : MemoryResource::Heap()) {
+}
+
+/*
+ * mmap only promises 4KB alignment. Map a page more than needed and unmap
+ * what sticks out on either side of the first 2MB boundary.
+ */
+void * HugePageResource::Allocate(size_t bytes, size_t alignment) {
+    if (bytes < minBytes) {
+        return upstream->Allocate(bytes, alignment);
+    }
+    const size_t size = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    char *region = (char *) mmap(NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        throw bad_alloc();
+    }
+    char *p = (char *) (((uintptr_t) region + HUGE_PAGE_SIZE - 1) & ~(uintptr_t) (HUGE_PAGE_SIZE - 1));
+    if (p > region) {
+        munmap(region, p - region);
+    }
+    munmap(p + size, region + HUGE_PAGE_SIZE - p);
+#ifdef MADV_HUGEPAGE
+    // Only a hint: without THP the pages are just small.
+    madvise(p, size, MADV_HUGEPAGE);
+#endif
+    return p;
+}
+
+void HugePageResource::Deallocate(void *p, size_t bytes, size_t alignment) {
+    if (bytes < minBytes) {
+        upstream->Deallocate(p, bytes, alignment);
+        return;
+    }
+    munmap(p, (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+}
@@ -0,0 +1,225 @@
+/*
+ * Arena.h
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include "common.h"
+
+/**
+ *
+ * Where a mesh gets its storage from, in the manner of std::pmr::memory_resource.
+ * The default is the global heap; an Arena lets many short-lived meshes share
+ * a few large blocks that are freed together, and a HugePageResource puts the arrays
+ * of a very large mesh on huge pages.
+ *
+ */
+class MemoryResource {
+public:
+    virtual ~MemoryResource() {}
+
+    /**
+     * @param alignment A power of two, at most alignof(max_align_t).
+     */
+    virtual void * Allocate(size_t bytes, size_t alignment) = 0;
+
+    /**
+     * Gives back what Allocate returned, with the same bytes and alignment.
+     */
+    virtual void Deallocate(void *p, size_t bytes, size_t alignment) = 0;
+
+    /**
+     * operator new and operator delete. Shared, never destroyed.
+     */
+    static MemoryResource * Heap();
+};
+
+/**
+ *
+ * Monotonic allocator: memory is carved out of blocks taken from the upstream
+ * resource, Deallocate does nothing and Release frees every block at once.
+ * Blocks double in size, so the arena takes O(log n) blocks to hand out n bytes.
+ * A vector that grows in an arena leaves its old buffers behind until Release;
+ * reserve first (see Mesh::Reserve, Mesh::Generate) to keep it to one buffer.
+ * Not thread safe: give every worker thread its own.
+ *
+ */
+class Arena : public MemoryResource {
+public:
+    /**
+     * @param blockSize Bytes of the first block.
+     * @param upstream Where the blocks come from, NULL for the heap.
+     */
+    explicit Arena(size_t blockSize = DEFAULT_BLOCK_SIZE, MemoryResource *upstream = NULL);
+    ~Arena();
+
+    void * Allocate(size_t bytes, size_t alignment);
+    void Deallocate(void *, size_t, size_t) {}
+
+    /**
+     * Frees every block. Whatever was allocated from the arena must not be used
+     * any more; meshes on it can still be destroyed, as that frees nothing.
+     * The next allocation starts over from the first block size.
+     */
+    void Release();
+
+    /**
+     * Same, but keeps the memory to carve from again. If it is in several blocks they are
+     * swapped for a single one as large as all of them, so that rebuilding meshes of the
+     * same size between Resets soon takes nothing from upstream.
+     */
+    void Reset();
+
+    /**
+     * Bytes taken from upstream, block headers included.
+     */
+    size_t GetBytesReserved() const { return bytesReserved; }
+
+    static const size_t DEFAULT_BLOCK_SIZE = 1 << 16;
+
+private:
+    Arena(const Arena &);
+    Arena & operator =(const Arena &);
+
+    struct Block {
+        Block   *previous;
+        size_t  size; // Header included.
+    };
+
+    /**
+     * Takes a block of size bytes, header included, from upstream and carves from it.
+     */
+    void NewBlock(size_t size);
+
+    /**
+     * Gives every block back to upstream.
+     */
+    void FreeBlocks();
+
+    MemoryResource  *upstream;
+    Block           *blocks; // The last one, which is being carved.
+    char            *cursor;
+    char            *end;
+    size_t          firstBlockSize;
+    size_t          nextBlockSize;
+    size_t          bytesReserved;
+};
+
+/**
+ *
+ * Backs large allocations with 2MB transparent huge pages: each gets its own mmap
+ * region, aligned to HUGE_PAGE_SIZE and marked madvise(MADV_HUGEPAGE), so that random
+ * accesses over a mesh of hundreds of MB miss the TLB far less often. Allocations
+ * smaller than minBytes go to the upstream resource instead of wasting a page.
+ * If the kernel has transparent huge pages disabled, the regions are plain memory.
+ * Thread safe.
+ *
+ */
+class HugePageResource : public MemoryResource {
+public:
+    /**
+     * @param minBytes Smallest allocation that gets its own region.
+     * @param upstream Where smaller allocations go, NULL for the heap.
+     */
+    explicit HugePageResource(size_t minBytes = HUGE_PAGE_SIZE / 2, MemoryResource *upstream = NULL);
+
+    /**
+     * Throws bad_alloc if mmap fails, as operator new would.
+     */
+    void * Allocate(size_t bytes, size_t alignment);
+    void Deallocate(void *p, size_t bytes, size_t alignment);
+
+    static const size_t HUGE_PAGE_SIZE = 2 << 20;
+
+private:
+    HugePageResource(const HugePageResource &);
+    HugePageResource & operator =(const HugePageResource &);
+
+    size_t          minBytes;
+    MemoryResource  *upstream;
+};
+
+/**
+ * Standard allocator on top of a MemoryResource, like std::pmr::polymorphic_allocator.
+ * Copies of a container keep the resource of the original.
+ */
+template<class T>
+class ResourceAllocator {
+public:
+    typedef T           value_type;
+    typedef T *         pointer;
+    typedef const T *   const_pointer;
+    typedef T &         reference;
+    typedef const T &   const_reference;
+    typedef size_t      size_type;
+    typedef ptrdiff_t   difference_type;
+
+    template<class U>
+    struct rebind {
+        typedef ResourceAllocator<U> other;
+    };
+
+    /**
+     * @param resource NULL for the heap.
+     */
+    ResourceAllocator(MemoryResource *resource = NULL) : resource(resource != NULL ? resource : MemoryResource::Heap()) {}
+
+    template<class U>
+    ResourceAllocator(const ResourceAllocator<U> &other) : resource(other.GetResource()) {}
+
+    T * allocate(size_t n, const void * = NULL) {
+        return static_cast<T *>(resource->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *p, size_t n) {
+        resource->Deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    template<class U, class... Args>
+    void construct(U *p, Args&&... args) {
+        ::new((void *) p) U(std::forward<Args>(args)...);
+    }
+
+    template<class U>
+    void destroy(U *p) {
+        p->~U();
+    }
+
+    size_t max_size() const {
+        return size_t(-1) / sizeof(T);
+    }
+
+    MemoryResource * GetResource() const { return resource; }
+
+private:
+    MemoryResource *resource;
+};
+
+template<class T, class U>
+bool operator ==(const ResourceAllocator<T> &a, const ResourceAllocator<U> &b) {
+    return a.GetResource() == b.GetResource();
+}
+
+template<class T, class U>
+bool operator !=(const ResourceAllocator<T> &a, const ResourceAllocator<U> &b) {
+    return a.GetResource() != b.GetResource();
+}
+
+#endif /* ARENA_H_ */
@@ -0,0 +1,191 @@
+/*
+ * Cli.cc
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common.h"
+#include "Mesh.h"
+#include "MappedMesh.h"
+#include "MappedPoints.h"
+#include <cstring>
+
+/*
+ * delaunay-cli: triangulates points without a window.
+ * Usage: delaunay-cli [--dc] [--threads N] [--f64 | --f32] [-o FILE] [--mesh FILE] [FILE]
+ * Reads "x y" pairs (whitespace or comma separated) from FILE, or stdin if there is
+ * none or it is "-", and writes the triangulation as OFF (z = 0) to stdout or -o FILE.
+ * With --f64 or --f32, FILE is mapped as packed binary x, y pairs instead.
+ * --mesh also saves the mesh in the binary format of MappedMesh.
+ * Vertices are written in mesh order, which is not the input order.
+ */
+
+namespace {
+
+/**
+ * Reads the whole stream and parses every number in it.
+ * @return false and prints the line on anything that is not a finite number.
+ */
+bool ReadPoints(FILE *in, vector<Vec> *verts) {
+    string text;
+    char buffer[1 << 16];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        text.append(buffer, read);
+    }
+    const char *p = text.c_str();
+    int line = 1;
+    vector<double> coords;
+    for (;;) {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ',') {
+            line += *p == '\n';
+            p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        char *end;
+        coords.push_back(strtod(p, &end));
+        if (end == p) {
+            fprintf(stderr, "delaunay-cli: line %d: expected a number\n", line);
+            return false;
+        }
+        if (!isfinite(coords.back())) {
+            // nan, inf or out of the range of a double: the predicates need real points.
+            fprintf(stderr, "delaunay-cli: line %d: not a finite number\n", line);
+            return false;
+        }
+        p = end;
+    }
+    if (coords.size() % 2 != 0) {
+        fprintf(stderr, "delaunay-cli: odd number of coordinates\n");
+        return false;
+    }
+    verts->reserve(coords.size() / 2);
+    for (int i = 0; i < (int) coords.size(); i += 2) {
+        verts->push_back(Vec(coords[i], coords[i + 1]));
+    }
+    return true;
+}
+
+/**
+ * Object File Format, ghost faces left out.
+ */
+void WriteOff(const Mesh &mesh, FILE *out) {
+    const Mesh::PointVector &verts = *mesh.GetVerts();
+    const Mesh::EdgeVector &edges = *mesh.GetEdges();
+    int numFaces = 0;
+    for (int f = 0; f < mesh.GetNumFaces(); ++f) {
+        numFaces += !mesh.IsGhost(f);
+    }
+    fprintf(out, "OFF\n%d %d 0\n", (int) verts.size(), numFaces);
+    for (const Vec2d &v : verts) {
+        fprintf(out, "%.17g %.17g 0\n", v.x, v.y);
+    }
+    for (int f = 0; f < mesh.GetNumFaces(); ++f) {
+        if (!mesh.IsGhost(f)) {
+            fprintf(out, "3 %d %d %d\n", edges[3 * f].point, edges[3 * f + 1].point, edges[3 * f + 2].point);
+        }
+    }
+}
+
+int Usage() {
+    fprintf(stderr, "Usage: delaunay-cli [--dc] [--threads N] [--f64 | --f32] [-o FILE] [--mesh FILE] [FILE]\n");
+    return 1;
+}
+
+}
+
+int main(int argc, char **argv) {
+    bool divideAndConquer = false;
+    int numThreads = 0;
+    const char *inPath = NULL;
+    const char *outPath = NULL;
+    const char *meshPath = NULL;
+    bool binary = false;
+    PointFormat format = PointFormat::DOUBLE;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--dc") == 0) {
+            divideAndConquer = true;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            numThreads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--f64") == 0 || strcmp(argv[i], "--f32") == 0) {
+            binary = true;
+            format = strcmp(argv[i], "--f64") == 0 ? PointFormat::DOUBLE : PointFormat::FLOAT;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (strcmp(argv[i], "--mesh") == 0 && i + 1 < argc) {
+            meshPath = argv[++i];
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            return Usage();
+        } else if (inPath == NULL) {
+            inPath = argv[i];
+        } else {
+            return Usage();
+        }
+    }
+
+    vector<Vec> verts;
+    MappedPoints points;
+    if (binary) {
+        if (inPath == NULL || !points.Open(inPath, format)) {
+            fprintf(stderr, "delaunay-cli: can't map %s\n", inPath == NULL ? "stdin" : inPath);
+            return 1;
+        }
+        if (divideAndConquer) {
+            points.AppendTo(&verts);
+            points.Close();
+        }
+    } else {
+        FILE *in = stdin;
+        if (inPath != NULL && strcmp(inPath, "-") != 0) {
+            in = fopen(inPath, "rb");
+            if (in == NULL) {
+                fprintf(stderr, "delaunay-cli: can't open %s\n", inPath);
+                return 1;
+            }
+        }
+        const bool ok = ReadPoints(in, &verts);
+        if (in != stdin) {
+            fclose(in);
+        }
+        if (!ok) {
+            return 1;
+        }
+    }
+
+    const Mesh mesh = divideAndConquer ? Mesh::GenerateDivideAndConquer(verts, numThreads)
+            : binary ? Mesh::Generate(points) : Mesh::Generate(verts);
+    points.Close();
+    if (meshPath != NULL && !MappedMesh::Save(mesh, meshPath)) {
+        fprintf(stderr, "delaunay-cli: can't write %s\n", meshPath);
+        return 1;
+    }
+
+    FILE *out = stdout;
+    if (outPath != NULL) {
+        out = fopen(outPath, "w");
+        if (out == NULL) {
+            fprintf(stderr, "delaunay-cli: can't write %s\n", outPath);
+            return 1;
+        }
+    }
+    WriteOff(mesh, out);
+    if (out != stdout && fclose(out) != 0) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,284 @@
+/*
+ * DivideAndConquer.cc
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DivideAndConquer.h"
+#include "Mesh.h"
+#include "Predicates.h"
+#include "Trace.h"
+
+template<class Real>
+DivideAndConquer<Real>::DivideAndConquer(const Point *verts, const vector<int> &unique) :
+        verts(verts), unique(unique) {
+    // A planar graph on m points has at most 3m - 3 edges (m >= 2), so every
+    // sub-problem fits in 3 edge slots per point.
+    const int numEdges = 2 * 3 * unique.size();
+    org.assign(numEdges, -1);
+    onext.resize(numEdges);
+    oprev.resize(numEdges);
+}
+
+template<class Real>
+/*static*/int DivideAndConquer<Real>::ForkDepth(int numThreads) {
+    if (numThreads <= 0) {
+        numThreads = max(1u, thread::hardware_concurrency());
+    }
+    int depth = 0;
+    while ((1 << depth) < numThreads) {
+        depth++;
+    }
+    return depth;
+}
+
+template<class Real>
+void DivideAndConquer<Real>::Run(BasicMesh<Real> *mesh, int numThreads) {
+    mesh->edges.clear();
+    mesh->incident.assign(mesh->verts.size(), -1);
+    mesh->locateHint = 0;
+    mesh->ghostIncident = -1;
+    mesh->Reserve(mesh->verts.size());
+    const int m = unique.size();
+    if (m < 2) {
+        return;
+    }
+    int le, re;
+    Pool pool;
+    {
+        ScopedPhase phase("Recurse");
+        Recurse(0, m, &le, &re, &pool, ForkDepth(numThreads));
+    }
+
+    ScopedPhase phase("Export");
+    // Every counter-clockwise three edge cycle is a face. The outer face is
+    // clockwise (or longer), so it is skipped.
+    vector<int> meshEdge(org.size(), -1);
+    for (int h = 0; h < (int) org.size(); ++h) {
+        if (org[h] == -1 || meshEdge[h] != -1) {
+            continue;
+        }
+        const int h1 = Lnext(h);
+        const int h2 = Lnext(h1);
+        if (Lnext(h2) != h || !Ccw(Org(h), Org(h1), Org(h2))) {
+            continue;
+        }
+        const int face = mesh->GetNumFaces();
+        mesh->edges.resize(3 * face + 3);
+        mesh->SetFace(face, Dest(h), Dest(h1), Dest(h2));
+        meshEdge[h] = 3 * face;
+        meshEdge[h1] = 3 * face + 1;
+        meshEdge[h2] = 3 * face + 2;
+    }
+    for (int h = 0; h < (int) org.size(); ++h) {
+        if (meshEdge[h] != -1) {
+            const int twin = meshEdge[Sym(h)];
+            mesh->edges[meshEdge[h]].twin = twin == -1 ? (int) HalfEdgeProperties::NO_TWIN : twin;
+        }
+    }
+    mesh->AddGhostFaces();
+}
+
+template<class Real>
+void DivideAndConquer<Real>::Recurse(int lo, int hi, int *le, int *re, Pool *pool, int depth) {
+    const int n = hi - lo;
+    if (n <= 3) {
+        // Leaf: hand the whole slot range of [lo, hi) to the pool.
+        pool->head = 3 * lo;
+        pool->tail = 3 * hi - 1;
+        for (int s = 3 * lo; s < 3 * hi; ++s) {
+            onext[2 * s] = s + 1 < 3 * hi ? s + 1 : -1;
+        }
+        const int s1 = unique[lo], s2 = unique[lo + 1];
+        const int a = MakeEdge(s1, s2, pool);
+        if (n == 2) {
+            *le = a;
+            *re = Sym(a);
+            return;
+        }
+        const int s3 = unique[lo + 2];
+        const int b = MakeEdge(s2, s3, pool);
+        Splice(Sym(a), b);
+        if (Ccw(s1, s2, s3)) {
+            Connect(b, a, pool);
+            *le = a;
+            *re = Sym(b);
+        } else if (Ccw(s1, s3, s2)) {
+            const int c = Connect(b, a, pool);
+            *le = Sym(c);
+            *re = c;
+        } else {
+            // Collinear.
+            *le = a;
+            *re = Sym(b);
+        }
+        return;
+    }
+    const int mid = (lo + hi) / 2;
+    int ldo, ldi, rdi, rdo;
+    Pool right;
+    if (depth > 0 && n >= PARALLEL_MIN) {
+        // The halves only touch the edge slots of their own point range.
+        thread left([&]() {
+            ScopedPhase phase("Subtree");
+            Recurse(lo, mid, &ldo, &ldi, pool, depth - 1);
+        });
+        Recurse(mid, hi, &rdi, &rdo, &right, depth - 1);
+        left.join();
+    } else {
+        Recurse(lo, mid, &ldo, &ldi, pool, 0);
+        Recurse(mid, hi, &rdi, &rdo, &right, 0);
+    }
+    if (pool->head == -1) {
+        *pool = right;
+    } else if (right.head != -1) {
+        onext[2 * pool->tail] = right.head;
+        pool->tail = right.tail;
+    }
+    Merge(ldo, ldi, rdi, rdo, le, re, pool);
+}
+
+template<class Real>
+void DivideAndConquer<Real>::Merge(int ldo, int ldi, int rdi, int rdo, int *le, int *re, Pool *pool) {
+    // Lower common tangent.
+    for (;;) {
+        if (LeftOf(Org(rdi), ldi)) {
+            ldi = Lnext(ldi);
+        } else if (RightOf(Org(ldi), rdi)) {
+            rdi = Rprev(rdi);
+        } else {
+            break;
+        }
+    }
+    int basel = Connect(Sym(rdi), ldi, pool);
+    if (Org(ldi) == Org(ldo)) {
+        ldo = Sym(basel);
+    }
+    if (Org(rdi) == Org(rdo)) {
+        rdo = basel;
+    }
+    // Zip upwards, deleting the edges that fail the circle test on each side.
+    for (;;) {
+        int lcand = Onext(Sym(basel));
+        const bool lvalid = RightOf(Dest(lcand), basel);
+        if (lvalid) {
+            while (InCircle(Dest(basel), Org(basel), Dest(lcand), Dest(Onext(lcand)))) {
+                const int t = Onext(lcand);
+                DeleteEdge(lcand, pool);
+                lcand = t;
+            }
+        }
+        int rcand = Oprev(basel);
+        const bool rvalid = RightOf(Dest(rcand), basel);
+        if (rvalid) {
+            while (InCircle(Dest(basel), Org(basel), Dest(rcand), Dest(Oprev(rcand)))) {
+                const int t = Oprev(rcand);
+                DeleteEdge(rcand, pool);
+                rcand = t;
+            }
+        }
+        if (!lvalid && !rvalid) {
+            break;
+        }
+        if (!lvalid || (rvalid && InCircle(Dest(lcand), Org(lcand), Org(rcand), Dest(rcand)))) {
+            basel = Connect(rcand, Sym(basel), pool);
+        } else {
+            basel = Connect(Sym(basel), Sym(lcand), pool);
+        }
+    }
+    *le = ldo;
+    *re = rdo;
+}
+
+template<class Real>
+int DivideAndConquer<Real>::MakeEdge(int from, int to, Pool *pool) {
+    assert(pool->head != -1);
+    const int e = 2 * pool->head;
+    pool->head = onext[e];
+    if (pool->head == -1) {
+        pool->tail = -1;
+    }
+    org[e] = from;
+    org[e + 1] = to;
+    onext[e] = oprev[e] = e;
+    onext[e + 1] = oprev[e + 1] = e + 1;
+    return e;
+}
+
+template<class Real>
+void DivideAndConquer<Real>::Splice(int a, int b) {
+    const int an = onext[a];
+    const int bn = onext[b];
+    onext[a] = bn;
+    onext[b] = an;
+    oprev[bn] = a;
+    oprev[an] = b;
+}
+
+template<class Real>
+int DivideAndConquer<Real>::Connect(int a, int b, Pool *pool) {
+    const int e = MakeEdge(Dest(a), Org(b), pool);
+    Splice(e, Lnext(a));
+    Splice(Sym(e), b);
+    return e;
+}
+
+template<class Real>
+void DivideAndConquer<Real>::DeleteEdge(int e, Pool *pool) {
+    Splice(e, Oprev(e));
+    Splice(Sym(e), Oprev(Sym(e)));
+    const int slot = e / 2;
+    org[2 * slot] = org[2 * slot + 1] = -1;
+    onext[2 * slot] = pool->head;
+    if (pool->head == -1) {
+        pool->tail = slot;
+    }
+    pool->head = slot;
+}
+
+template<class Real>
+bool DivideAndConquer<Real>::Ccw(int a, int b, int c) const {
+    return Predicates::Orient2d(verts[a], verts[b], verts[c]) > 0;
+}
+
+/*
+ * The hottest test of the merge. Only the filter of the predicate is inlined here;
+ * the rest is out of line, as it is hardly ever needed on points in general position.
+ */
+template<class Real>
+inline bool DivideAndConquer<Real>::InCircle(int a, int b, int c, int d) const {
+    const double det = Predicates::InCircleFilter(verts[a], verts[b], verts[c], verts[d]);
+    if (det != 0) {
+        return det > 0;
+    }
+    return InCircleSlow(a, b, c, d);
+}
+
+template<class Real>
+bool DivideAndConquer<Real>::InCircleSlow(int a, int b, int c, int d) const {
+    // The merge asks about a point of the triangle itself once per side and step.
+    // That is exactly zero, but it would take the slow path of the predicate.
+    if (d == a || d == b || d == c) {
+        return false;
+    }
+    // Perturbed like Mesh::IsInsideCircumcircle, so both build the same mesh.
+    return Predicates::InCirclePerturbed(verts[a], verts[b], verts[c], verts[d]) > 0;
+}
+
+template class DivideAndConquer<float>;
+template class DivideAndConquer<double>;
+template class DivideAndConquer<int32_t>;
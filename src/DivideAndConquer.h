@@ -0,0 +1,148 @@
+/*
+ * DivideAndConquer.h
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DIVIDEANDCONQUER_H_
+#define DIVIDEANDCONQUER_H_
+
+#include "common.h"
+#include <thread>
+
+template<class Real> class BasicMesh;
+
+/**
+ *
+ * Guibas-Stolfi divide and conquer Delaunay triangulation.
+ * Works on its own edge structure, where faces are implicit and the edges out of a
+ * vertex form a ring (onext / oprev). The result is written into a Mesh.
+ * Used through Mesh::GenerateDivideAndConquer.
+ *
+ * The two halves of a split share nothing until they are merged, so the top levels
+ * of the recursion run on their own threads.
+ *
+ */
+template<class Real>
+class DivideAndConquer {
+public:
+    typedef Vec2<Real> Point;
+
+    /**
+     * @param verts Points sorted by x, then y.
+     * @param unique Indices into verts of the points to triangulate, without duplicates.
+     */
+    DivideAndConquer(const Point *verts, const vector<int> &unique);
+
+    /**
+     * Triangulates the points and writes the faces into mesh, whose verts must be verts.
+     * @param numThreads Threads to split the work over. 0 uses every core.
+     */
+    void Run(BasicMesh<Real> *mesh, int numThreads);
+
+    /**
+     * Order used by the engine: by x, then y.
+     */
+    template<class P>
+    static bool Less(const P &a, const P &b) {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    }
+
+    /**
+     * Sorts [begin, end) with less, merging halves sorted on separate threads.
+     */
+    template<class It, class Compare>
+    static void Sort(It begin, It end, Compare less, int numThreads) {
+        SortRange(begin, end, less, ForkDepth(numThreads));
+    }
+
+    /**
+     * Sub-problems smaller than this are not worth a thread.
+     */
+    static const int PARALLEL_MIN = 1 << 13;
+
+private:
+    /**
+     * Free edges, linked through onext. Every sub-problem owns the slots of
+     * its range of points, so sub-problems never share a pool.
+     */
+    struct Pool {
+        int head;
+        int tail;
+    };
+
+    /**
+     * Triangulates unique[lo, hi).
+     * @param le Hull edge out of the leftmost point, counter-clockwise.
+     * @param re Hull edge out of the rightmost point, clockwise.
+     * @param depth Levels left that may still fork a thread.
+     */
+    void Recurse(int lo, int hi, int *le, int *re, Pool *pool, int depth);
+
+    template<class It, class Compare>
+    static void SortRange(It begin, It end, Compare less, int depth) {
+        if (depth == 0 || end - begin < PARALLEL_MIN) {
+            sort(begin, end, less);
+            return;
+        }
+        const It mid = begin + (end - begin) / 2;
+        thread left(SortRange<It, Compare>, begin, mid, less, depth - 1);
+        SortRange(mid, end, less, depth - 1);
+        left.join();
+        inplace_merge(begin, mid, end, less);
+    }
+
+    /**
+     * Number of times numThreads has to be halved to get to one thread.
+     */
+    static int ForkDepth(int numThreads);
+
+    /**
+     * Stitches two triangulations separated by a vertical line.
+     * ldo / ldi and rdi / rdo are the hull edges returned by Recurse.
+     */
+    void Merge(int ldo, int ldi, int rdi, int rdo, int *le, int *re, Pool *pool);
+
+    // Edge algebra. A half edge is e, its symmetric is e ^ 1.
+    static int Sym(int e) { return e ^ 1; }
+    int Org(int e) const { return org[e]; }
+    int Dest(int e) const { return org[Sym(e)]; }
+    int Onext(int e) const { return onext[e]; }
+    int Oprev(int e) const { return oprev[e]; }
+    int Lnext(int e) const { return oprev[Sym(e)]; }
+    int Rprev(int e) const { return onext[Sym(e)]; }
+
+    int MakeEdge(int from, int to, Pool *pool);
+    void Splice(int a, int b);
+    int Connect(int a, int b, Pool *pool);
+    void DeleteEdge(int e, Pool *pool);
+
+    // Predicates on vertices.
+    bool Ccw(int a, int b, int c) const;
+    bool InCircle(int a, int b, int c, int d) const;
+    bool InCircleSlow(int a, int b, int c, int d) const; // Once the filter of InCircle gave up.
+    bool RightOf(int x, int e) const { return Ccw(x, Dest(e), Org(e)); }
+    bool LeftOf(int x, int e) const { return Ccw(x, Org(e), Dest(e)); }
+
+    const Point         *verts;
+    const vector<int>   &unique;
+    vector<int>         org;    // Origin vertex of each half edge. -1 if free.
+    vector<int>         onext;  // Next half edge counter-clockwise around the origin.
+    vector<int>         oprev;  // Next half edge clockwise around the origin.
+};
+
+#endif /* DIVIDEANDCONQUER_H_ */
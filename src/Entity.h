@@ -26,7 +26,10 @@ class Renderer;
 
 enum class EntityType{
     UNDEFINED = 0,
-    MESH
+    MESH,
+    FLOAT_MESH,
+    INT_MESH,
+    MAPPED_MESH
 };
 
 /**
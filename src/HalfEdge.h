@@ -24,24 +24,24 @@
 /**
  *
  * The half edge data structure stores topology information.
- * It has three indices that act as pointers to the structures of a Mesh.
- * The indices point to the incident vector,
- *  to the next counter clockwise half edge, and to its twin edge,
- * inversely oriented and part of an adjacent face.
+ * It has two indices that act as pointers to the structures of a Mesh:
+ * the point it ends at and its twin edge, inversely oriented and part of an
+ * adjacent face. The next counter clockwise half edge is not stored, it follows
+ * from the position of the edge in its face (see Mesh::Next).
  *
  */
 
 enum class HalfEdgeProperties {
-    NO_TWIN = -1
+    NO_TWIN = -1,
+    GHOST = -2      // Point index of the vertex at infinity, see Mesh::IsGhost.
 };
 
 class HalfEdge {
 public:
     // Constructor.
-    HalfEdge() : point(0), next(0), twin((int) HalfEdgeProperties::NO_TWIN) {}
+    HalfEdge() : point(0), twin((int) HalfEdgeProperties::NO_TWIN) {}
     bool operator ==(const HalfEdge &e);
     int         point;
-    int         next;
     int         twin;
 
 };
@@ -52,7 +52,7 @@ public:
 typedef HalfEdge* Face;
 
 inline bool HalfEdge::operator ==(const HalfEdge & e) {
-    return point == e.point && next == e.next && twin == e.twin;
+    return point == e.point && twin == e.twin;
 }
 
 
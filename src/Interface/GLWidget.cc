@@ -19,7 +19,6 @@
  */
 
 #include "GLWidget.h"
-#include "../Mesh.h" // For click generation
 
 extern int W;
 extern int H;
@@ -45,7 +44,6 @@ void GLWidget::paintGL() {
     glClearColor(1,1,1,1);
     glColor3f(0,0,0);
 
-    const Mesh mesh = Mesh::Generate(&clicks);
     renderer.Push(&mesh);
     renderer.Render();
     renderer.Remove(&mesh);
@@ -60,14 +58,14 @@ void GLWidget::resizeGL(int width, int height) {
 }
 
 void GLWidget::mousePressEvent(QMouseEvent *event) {
-    Vec pt(event->pos().x(), rect().height() - event->pos().y());
-    clicks.push_back(pt);
+    Vec2i pt(event->pos().x(), rect().height() - event->pos().y());
+    mesh.Insert(pt);
     updateGL();
 }
 
 void GLWidget::keyPressEvent(QKeyEvent *event) {
     if(event->key() == Qt::Key_R) {
-        clicks.clear();
+        mesh.Clear();
         updateGL();
     }
 }
@@ -21,7 +21,9 @@
 #define GLWIDGET_H_
 
 #include "../common.h"
+#include "Qt.h"
 #include "../Renderer.h"
+#include "../Mesh.h"
 
 class GLWidget : QGLWidget{
 public:
@@ -34,7 +36,7 @@ protected:
     void keyPressEvent(QKeyEvent * event);
 private:
     Renderer renderer;
-    vector<Vec> clicks;
+    IntMesh mesh; // Clicks are inserted as they come, in pixels.
 };
 
 #endif /* GLWIDGET_H_ */
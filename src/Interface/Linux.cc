@@ -19,6 +19,7 @@
  */
 
 #include "../common.h"
+#include "Qt.h"
 #include "Window.h"
 
 int W = 640;
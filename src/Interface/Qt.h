@@ -0,0 +1,35 @@
+/*
+ * Qt.h
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QT_H_
+#define QT_H_
+
+/**
+ * Qt and OpenGL, for the window only. The mesh code doesn't depend on them,
+ * see common.h.
+ */
+#ifdef __linux__
+#include <QApplication>
+#include <QDesktopWidget>
+#include <qt4/QtGui/QDesktopWidget>
+#include <QtGui>
+#include <QtOpenGL>
+#endif
+
+#endif /* QT_H_ */
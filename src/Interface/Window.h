@@ -21,6 +21,7 @@
 #define WINDOW_H_
 
 #include "../common.h"
+#include "Qt.h"
 class GLWidget;
 
 class Window: public QWidget {
@@ -0,0 +1,162 @@
+/*
+ * MappedMesh.cc
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MappedMesh.h"
+#include "Mesh.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+const char MappedMesh::MESH_FILE_MAGIC[8] = { 'D', 'E', 'L', 'A', 'U', 'N', 'A', 'Y' };
+
+namespace {
+
+uint64_t Align(uint64_t offset) {
+    return (offset + MappedMesh::SECTION_ALIGN - 1) / MappedMesh::SECTION_ALIGN * MappedMesh::SECTION_ALIGN;
+}
+
+bool LittleEndian() {
+    const uint32_t one = 1;
+    return *(const char *) &one == 1;
+}
+
+bool WriteAt(FILE *f, uint64_t offset, const void *data, size_t size) {
+    // Pad up to the section.
+    while ((uint64_t) ftell(f) < offset) {
+        if (fputc(0, f) == EOF) {
+            return false;
+        }
+    }
+    return size == 0 || fwrite(data, size, 1, f) == 1;
+}
+
+}
+
+/*static*/bool MappedMesh::Save(const Mesh &mesh, const string &path) {
+    if (!LittleEndian()) {
+        return false;
+    }
+    const Mesh::PointVector &verts = *mesh.GetVerts();
+    const Mesh::EdgeVector &edges = *mesh.GetEdges();
+    MeshFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MESH_FILE_MAGIC, sizeof(header.magic));
+    header.version = MESH_FILE_VERSION;
+    header.vecSize = sizeof(Vec2d);
+    header.edgeSize = sizeof(HalfEdge);
+    header.locateHint = mesh.GetLocateHint();
+    header.numVerts = verts.size();
+    header.numEdges = edges.size();
+    header.vertsOffset = Align(sizeof(header));
+    header.edgesOffset = Align(header.vertsOffset + verts.size() * sizeof(Vec2d));
+
+    FILE *f = fopen(path.c_str(), "wb");
+    if (f == NULL) {
+        return false;
+    }
+    bool ok = WriteAt(f, 0, &header, sizeof(header))
+            && WriteAt(f, header.vertsOffset, verts.data(), verts.size() * sizeof(Vec2d))
+            && WriteAt(f, header.edgesOffset, edges.data(), edges.size() * sizeof(HalfEdge));
+    ok = fclose(f) == 0 && ok;
+    return ok;
+}
+
+MappedMesh::MappedMesh() : data(NULL), length(0), verts(NULL), edges(NULL), numVerts(0), numEdges(0),
+        locateHint(0) {
+    type = EntityType::MAPPED_MESH;
+}
+
+MappedMesh::~MappedMesh() {
+    Close();
+}
+
+bool MappedMesh::Open(const string &path) {
+    Close();
+    if (!LittleEndian()) {
+        return false;
+    }
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(MeshFileHeader)) {
+        close(fd);
+        return false;
+    }
+    void *p = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+    const MeshFileHeader &header = *(const MeshFileHeader *) p;
+    const uint64_t size = info.st_size;
+    const bool valid = memcmp(header.magic, MESH_FILE_MAGIC, sizeof(header.magic)) == 0
+            && header.version == MESH_FILE_VERSION
+            && header.vecSize == sizeof(Vec2d) && header.edgeSize == sizeof(HalfEdge)
+            && header.numVerts <= (uint64_t) INT32_MAX && header.numEdges <= (uint64_t) INT32_MAX
+            && header.numEdges % 3 == 0
+            && header.vertsOffset % SECTION_ALIGN == 0 && header.edgesOffset % SECTION_ALIGN == 0
+            && header.vertsOffset <= size && header.numVerts * sizeof(Vec2d) <= size - header.vertsOffset
+            && header.edgesOffset <= size && header.numEdges * sizeof(HalfEdge) <= size - header.edgesOffset
+            && (header.numEdges == 0 || (header.locateHint >= 0 && (uint64_t) header.locateHint < header.numEdges));
+    if (!valid) {
+        munmap(p, info.st_size);
+        return false;
+    }
+    data = p;
+    length = info.st_size;
+    verts = (const Vec2d *) ((const char *) p + header.vertsOffset);
+    edges = (const HalfEdge *) ((const char *) p + header.edgesOffset);
+    numVerts = header.numVerts;
+    numEdges = header.numEdges;
+    locateHint = header.locateHint;
+    return true;
+}
+
+void MappedMesh::Close() {
+    if (data != NULL) {
+        munmap(data, length);
+    }
+    data = NULL;
+    length = 0;
+    verts = NULL;
+    edges = NULL;
+    numVerts = 0;
+    numEdges = 0;
+    locateHint = 0;
+}
+
+bool MappedMesh::IsGhost(int faceIndex) const {
+    return Mesh::IsGhost(edges, faceIndex);
+}
+
+int MappedMesh::Locate(const Vec2d &v, int *hint) const {
+    if (numEdges == 0) {
+        return -1;
+    }
+    const int start = hint != NULL && *hint >= 0 && *hint < numEdges ? *hint : locateHint;
+    const int ei = Mesh::Walk(edges, verts, start, v, NULL);
+    if (hint != NULL) {
+        *hint = ei;
+    }
+    const int face = Mesh::FaceOf(ei);
+    return IsGhost(face) ? -1 : face;
+}
@@ -0,0 +1,118 @@
+/*
+ * MappedMesh.h
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAPPEDMESH_H_
+#define MAPPEDMESH_H_
+
+#include "common.h"
+#include "Entity.h"
+
+template<class Real> class BasicMesh;
+typedef BasicMesh<double> Mesh;
+
+/**
+ * Header of a saved mesh. Every field is little endian, the sections are
+ * aligned to SECTION_ALIGN bytes from the start of the file:
+ *  verts: numVerts Vec2d (x, y doubles).
+ *  edges: numEdges HalfEdge (point, twin int32), three per face, ghost faces included.
+ * Faces are implicit (see Mesh::GetNumFaces), so there is no face section.
+ */
+struct MeshFileHeader {
+    char        magic[8];   // MESH_FILE_MAGIC
+    uint32_t    version;    // MESH_FILE_VERSION
+    uint32_t    vecSize;    // sizeof(Vec2d) and sizeof(HalfEdge) of the writer. A file with
+    uint32_t    edgeSize;   // another layout is refused rather than misread.
+    int32_t     locateHint; // Edge to start walking from: where the mesh walked last.
+    uint64_t    numVerts;
+    uint64_t    numEdges;
+    uint64_t    vertsOffset;
+    uint64_t    edgesOffset;
+};
+
+/**
+ *
+ * A mesh saved with Save, mapped read-only and used in place: opening costs the
+ * same whatever the size of the mesh, pages are read as the queries and the
+ * Renderer touch them. It can't be edited.
+ *
+ */
+class MappedMesh : public Entity {
+public:
+    static const char MESH_FILE_MAGIC[8];
+    static const uint32_t MESH_FILE_VERSION = 3; // 1 stored Vec (x, y, z), 2 stored next edges.
+    static const int SECTION_ALIGN = 64;
+
+    /**
+     * Writes mesh to path.
+     * @return false if the file can't be written.
+     */
+    static bool Save(const Mesh &mesh, const string &path);
+
+    MappedMesh();
+    ~MappedMesh();
+
+    /**
+     * Maps a file written by Save. Anything mapped before is unmapped.
+     * Only the header is checked, the edges are trusted to be a mesh.
+     * @return false if it can't be mapped or is not a mesh file of this version and layout.
+     */
+    bool Open(const string &path);
+
+    void Close();
+
+    int GetNumVerts() const {
+        return numVerts;
+    }
+    const Vec2d * GetVerts() const {
+        return verts;
+    }
+    int GetNumFaces() const {
+        return numEdges / 3;
+    }
+    const HalfEdge * GetEdges() const {
+        return edges;
+    }
+
+    /**
+     * See Mesh::IsGhost.
+     */
+    bool IsGhost(int faceIndex) const;
+
+    /**
+     * See Mesh::Locate. The mapping is never written, so any number of threads can locate
+     * at once, each with its own hint.
+     * @param hint If not NULL, the edge to walk from, set to where the walk ended: nearby
+     *        queries in a row stay short. Out of range (e.g. -1) starts from the saved hint.
+     */
+    int Locate(const Vec2d &v, int *hint = NULL) const;
+
+private:
+    MappedMesh(const MappedMesh &);
+    MappedMesh & operator =(const MappedMesh &);
+
+    void            *data;
+    size_t          length; // Bytes mapped.
+    const Vec2d     *verts;
+    const HalfEdge  *edges;
+    int             numVerts;
+    int             numEdges;
+    int             locateHint; // Saved with the mesh.
+};
+
+#endif /* MAPPEDMESH_H_ */
@@ -0,0 +1,120 @@
+/*
+ * MappedPoints.cc
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MappedPoints.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+// Pages are released in chunks of this many points.
+const int RELEASE_POINTS = 1 << 20;
+
+bool LittleEndian() {
+    const uint32_t one = 1;
+    return *(const char *) &one == 1;
+}
+
+}
+
+MappedPoints::MappedPoints() : data(NULL), length(0), numPoints(0), format(PointFormat::DOUBLE) {
+}
+
+MappedPoints::~MappedPoints() {
+    Close();
+}
+
+bool MappedPoints::Open(const string &path, PointFormat format) {
+    Close();
+    // The points are read as they are in the file.
+    if (!LittleEndian()) {
+        return false;
+    }
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat info;
+    const size_t pointSize = format == PointFormat::DOUBLE ? 2 * sizeof(double) : 2 * sizeof(float);
+    if (fstat(fd, &info) != 0 || info.st_size % pointSize != 0
+            || info.st_size / pointSize > (size_t) INT32_MAX) {
+        close(fd);
+        return false;
+    }
+    if (info.st_size > 0) {
+        void *p = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        madvise(p, info.st_size, MADV_SEQUENTIAL);
+        data = p;
+    }
+    // The mapping keeps the file alive.
+    close(fd);
+    length = info.st_size;
+    numPoints = length / pointSize;
+    this->format = format;
+    return true;
+}
+
+void MappedPoints::Close() {
+    if (data != NULL) {
+        munmap(data, length);
+    }
+    data = NULL;
+    length = 0;
+    numPoints = 0;
+}
+
+template<class Point>
+void MappedPoints::AppendTo(vector<Point> *verts) const {
+    const size_t size = verts->size();
+    verts->resize(size + numPoints);
+    CopyTo(verts->data() + size);
+}
+
+template<class Point>
+void MappedPoints::CopyTo(Point *points) const {
+    const size_t pointSize = length / max(1, numPoints);
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    size_t released = 0;
+    for (int begin = 0; begin < numPoints; begin += RELEASE_POINTS) {
+        const int end = min(numPoints, begin + RELEASE_POINTS);
+        for (int i = begin; i < end; ++i) {
+            const Vec2d v = Get(i);
+            points[i] = Point(v.x, v.y);
+        }
+        // Whole pages that were read. They fault in from the file again if needed.
+        const size_t done = end * pointSize / pageSize * pageSize;
+        if (done > released) {
+            madvise((char *) data + released, done - released, MADV_DONTNEED);
+            released = done;
+        }
+    }
+}
+
+template void MappedPoints::AppendTo<Vec>(vector<Vec> *) const;
+template void MappedPoints::AppendTo<Vec2d>(vector<Vec2d> *) const;
+template void MappedPoints::AppendTo<Vec2f>(vector<Vec2f> *) const;
+template void MappedPoints::AppendTo<Vec2i>(vector<Vec2i> *) const;
+template void MappedPoints::CopyTo<Vec2d>(Vec2d *) const;
+template void MappedPoints::CopyTo<Vec2f>(Vec2f *) const;
+template void MappedPoints::CopyTo<Vec2i>(Vec2i *) const;
@@ -0,0 +1,91 @@
+/*
+ * MappedPoints.h
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAPPEDPOINTS_H_
+#define MAPPEDPOINTS_H_
+
+#include "common.h"
+
+/**
+ * Layout of a point file: x, y pairs with nothing in between, little endian.
+ */
+enum class PointFormat {
+    DOUBLE = 0,     // 16 bytes per point.
+    FLOAT           // 8 bytes per point.
+};
+
+/**
+ *
+ * A binary point file mapped into memory. Nothing is read up front: pages are
+ * faulted in as the points are used, read ahead since access is sequential,
+ * and can be dropped by the kernel at any time since they stay backed by the file.
+ *
+ */
+class MappedPoints {
+public:
+    MappedPoints();
+    ~MappedPoints();
+
+    /**
+     * Maps path. Anything mapped before is unmapped.
+     * @return false if the file can't be mapped or its size is not a whole number of points.
+     *         Always false on a big endian host.
+     */
+    bool Open(const string &path, PointFormat format);
+
+    void Close();
+
+    int GetNumPoints() const {
+        return numPoints;
+    }
+
+    Vec2d Get(int i) const {
+        if (format == PointFormat::DOUBLE) {
+            const double *p = (const double *) data + 2 * i;
+            return Vec2d(p[0], p[1]);
+        }
+        const float *p = (const float *) data + 2 * i;
+        return Vec2d(p[0], p[1]);
+    }
+
+    /**
+     * Appends every point to verts in one pass, handing the pages back to the
+     * kernel behind it, so that the file and the copy are not both resident.
+     * Point is Vec, Vec2d, Vec2f or Vec2i.
+     */
+    template<class Point>
+    void AppendTo(vector<Point> *verts) const;
+
+    /**
+     * Same, into points[0, GetNumPoints()), which the caller has made room for.
+     */
+    template<class Point>
+    void CopyTo(Point *points) const;
+
+private:
+    MappedPoints(const MappedPoints &);
+    MappedPoints & operator =(const MappedPoints &);
+
+    void        *data;
+    size_t      length; // Bytes mapped.
+    int         numPoints;
+    PointFormat format;
+};
+
+#endif /* MAPPEDPOINTS_H_ */
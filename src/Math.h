@@ -22,6 +22,7 @@
 #define MATH_H_
 
 #include "Vec.h"
+#include "Vec2.h"
 #include "HalfEdge.h"
 
 
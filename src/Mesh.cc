@@ -19,379 +19,972 @@
  */
 
 #include "Mesh.h"
-
-Mesh::Mesh() {
-    type = EntityType::MESH;
+#include "DivideAndConquer.h"
+#include "MappedPoints.h"
+#include "Predicates.h"
+#include "Trace.h"
+
+#ifdef MESH_STATS
+#define MESH_STAT(statement) statement
+#else
+#define MESH_STAT(statement)
+#endif
+
+template<> const EntityType BasicMesh<double>::ENTITY_TYPE = EntityType::MESH;
+template<> const EntityType BasicMesh<float>::ENTITY_TYPE = EntityType::FLOAT_MESH;
+template<> const EntityType BasicMesh<int32_t>::ENTITY_TYPE = EntityType::INT_MESH;
+
+template<class Real>
+BasicMesh<Real>::BasicMesh(MemoryResource *resource)
+        : verts(resource), edges(resource), incident(resource), locateHint(0), ghostIncident(-1),
+          duplicates(resource), flipStack(resource), starScratch(resource), orderScratch(resource), sortScratch(resource) {
+    type = ENTITY_TYPE;
+    ResetStats();
 }
 
-const vector<HalfEdge> * Mesh::GetEdges() const {
+template<class Real>
+const typename BasicMesh<Real>::EdgeVector * BasicMesh<Real>::GetEdges() const {
     return &edges;
 }
 
-const vector<Vec> * Mesh::GetVerts() const {
+template<class Real>
+const typename BasicMesh<Real>::PointVector * BasicMesh<Real>::GetVerts() const {
     return &verts;
 }
 
-const set<int> * Mesh::GetFaces() const {
-    return &faces;
+template<class Real>
+int BasicMesh<Real>::GetNumFaces() const {
+    return edges.size() / 3;
 }
 
-//Todo: Sanity check.
-/*static*/const Mesh Mesh::Generate(vector<Vec> *inVerts) {
-    Mesh result;
-    if (inVerts->size() <= 0) {
-        return result;
-    }
-    // Copy all verts
-    random_shuffle(inVerts->begin(),inVerts->end());
-    result.verts = *inVerts;
+template<class Real>
+/*static*/bool BasicMesh<Real>::InRange(const Vec &) {
+    return true;
+}
 
-    // Get bounding triangle
-    vector<Vec> triangle = result.GetBoundingTriangle();
+template<class Real>
+/*static*/bool BasicMesh<Real>::InRange(const Point &) {
+    return true;
+}
 
-    // First face : ==========
-    // Push the triangle. Will remove at the end
-    for (Vec v : triangle) {
-        result.verts.push_back(v);
-    }
+template<>
+/*static*/bool BasicMesh<int32_t>::InRange(const Vec &v) {
+    // Also false for nan.
+    return fabs(v.x) <= Predicates::INT_COORD_MAX && fabs(v.y) <= Predicates::INT_COORD_MAX;
+}
 
-    // Add edges for the triangle.
-    for (int i = result.verts.size() - 3; i < result.verts.size(); ++i) {
-        HalfEdge e;
-        e.point = i;
-        result.edges.push_back(e);
-    }
+template<>
+/*static*/bool BasicMesh<int32_t>::InRange(const Point &v) {
+    return v.x >= -Predicates::INT_COORD_MAX && v.x <= Predicates::INT_COORD_MAX
+            && v.y >= -Predicates::INT_COORD_MAX && v.y <= Predicates::INT_COORD_MAX;
+}
 
-    // Adjacency for the triangle.
-    for (int i = 0; i < result.edges.size(); ++i) {
-        result.edges[i].next = (i + 1) % result.edges.size();
-    }
-    result.faces.insert(0);
-    //========================
+template<class Real>
+typename BasicMesh<Real>::Stats BasicMesh<Real>::GetStats() const {
+    Stats result = stats;
+    result.edgesLive = edges.size();
+    result.edgesCapacity = edges.capacity();
+    return result;
+}
+
+template<class Real>
+void BasicMesh<Real>::ResetStats() {
+    stats = Stats();
+}
 
-    // The last three points are the bounding triangle.
+template<class Real>
+/*static*/bool BasicMesh<Real>::StatsEnabled() {
+#ifdef MESH_STATS
+    return true;
+#else
+    return false;
+#endif
+}
 
-    // Split containing face for each point that is not part of the bounding triangle.
-    for (int iVec = 0; iVec < result.verts.size() - 2; iVec++) {
-        int iFace = result.GetContainingFace(iVec);
-        result.SplitFace(iFace, iVec);
+template<class Real>
+/*static*/void BasicMesh<Real>::Generate(const Vec *points, int count, BasicMesh *mesh,
+        vector<int> *inputIndex, InsertionOrder order) {
+    ScopedPhase phase("Generate");
+    int *index;
+    if (inputIndex != NULL) {
+        inputIndex->resize(count);
+        index = inputIndex->data();
+    } else {
+        mesh->orderScratch.resize(count);
+        index = mesh->orderScratch.data();
+    }
+    if (order == InsertionOrder::BRIO) {
+        ScopedPhase phase("BrioSort");
+        SpatialSort::BrioOrder(points, count, index, &mesh->sortScratch);
+    } else {
+        ScopedPhase phase("Shuffle");
+        for (int i = 0; i < count; ++i) {
+            index[i] = i;
+        }
+        random_shuffle(index, index + count);
     }
-    int nfaces = result.faces.size();
-    set<int> todelete;
-    for(int ei = 0; ei < result.edges.size(); ++ei) {
-        auto edge = result.edges[ei];
-        auto point = edge.point;
-        auto size = result.verts.size();
-        if(point == size-1 || point == size-2 || point == size-3) {
-            auto face = result.FindFace(ei);
-            todelete.insert(face);
+    {
+        ScopedPhase phase("Copy");
+        mesh->verts.resize(count);
+        for (int i = 0; i < count; ++i) {
+            assert(InRange(points[index[i]]));
+            mesh->verts[i] = Point(points[index[i]]);
         }
     }
-    for(auto face : todelete) {
-        result.RemoveFace(face);
+    mesh->Triangulate();
+}
+
+template<class Real>
+/*static*/BasicMesh<Real> BasicMesh<Real>::Generate(const vector<Vec> &verts, InsertionOrder order) {
+    BasicMesh result;
+    Generate(verts.data(), verts.size(), &result, NULL, order);
+    return result;
+}
+
+template<class Real>
+/*static*/BasicMesh<Real> BasicMesh<Real>::Generate(const MappedPoints &points, InsertionOrder order) {
+    ScopedPhase phase("Generate");
+    BasicMesh result;
+    {
+        // The only copy: the points are ordered in the mesh itself.
+        ScopedPhase phase("Copy");
+        for (int i = 0; i < points.GetNumPoints(); ++i) {
+            assert(InRange(Vec(points.Get(i).x, points.Get(i).y)));
+        }
+        result.verts.resize(points.GetNumPoints());
+        points.CopyTo(result.verts.data());
     }
-    // Pop triangle verts.
-    for(int i = 0; i < 3; i++) {
-        result.verts.pop_back();
+    if (result.verts.empty()) {
+        return result;
     }
+    result.Order(order);
+    result.Triangulate();
     return result;
 }
 
-/**
- * General idea:
- * a) Get the center of the bounding box of the points.
- * b) Get the farthest point from the center and calculate the distance. Add an epsilon.
- * c) Create a triangle that has two sides tangent to the circle derived from the center and the distance.
- *    One point is directly above. The edges are tangent at a 45 degree angle to make the math simpler.
- *    The other two points are symmetrical so we really only calculate one.
- */
-vector<Vec> Mesh::GetBoundingTriangle() {
-    const double epsilon = 0.5; //Used to make the triangle a little larger so that points don't intersect
-    // Find the center.
-    assert(verts.size() > 0);
-    const Vec v0 = verts[0];
-    double left = v0.x, right = v0.x, top = v0.y, bottom = v0.y;
-    for (Vec v : verts) {
-        if (v.x < left)
-            left = v.x;
-        if (v.x > right)
-            right = v.x;
-        if (v.y < bottom)
-            bottom = v.y;
-        if (v.y > top)
-            top = v.y;
+template<class Real>
+void BasicMesh<Real>::Order(InsertionOrder order) {
+    if (order == InsertionOrder::BRIO) {
+        ScopedPhase phase("BrioSort");
+        const int n = verts.size();
+        orderScratch.resize(n);
+        SpatialSort::BrioOrder(verts.data(), n, orderScratch.data(), &sortScratch);
+        // verts[i] = verts[order[i]], in place: each cycle of the permutation is followed
+        // with one point in hand. Done slots get order[j] = j.
+        int *order = orderScratch.data();
+        for (int i = 0; i < n; ++i) {
+            if (order[i] == i) {
+                continue;
+            }
+            const Point first = verts[i];
+            int j = i;
+            while (order[j] != i) {
+                const int k = order[j];
+                verts[j] = verts[k];
+                order[j] = j;
+                j = k;
+            }
+            verts[j] = first;
+            order[j] = j;
+        }
+    } else {
+        ScopedPhase phase("Shuffle");
+        random_shuffle(verts.begin(), verts.end());
     }
-    Vec center(left + (right - left) / 2, bottom + (top - bottom) / 2);
+}
 
-    // Find the vector farthest away from the center.
-    // This is the radius of a circle that contains all points.
-    double radius = 0;
-    for (Vec v : verts) {
-        double const newDist = center.Magnitude2d(v);
-        if (newDist > radius) {
-            radius = newDist;
+template<class Real>
+/*static*/void BasicMesh<Real>::GenerateDivideAndConquer(const Vec *points, int count, BasicMesh *mesh,
+        vector<int> *inputIndex, int numThreads) {
+    ScopedPhase phase("GenerateDivideAndConquer");
+    vector<int> localIndex;
+    vector<int> &index = inputIndex != NULL ? *inputIndex : localIndex;
+    for (int i = 0; i < count; ++i) {
+        assert(InRange(points[i])); // Before the sort converts them.
+    }
+    {
+        ScopedPhase phase("Sort");
+        index.resize(count);
+        for (int i = 0; i < count; ++i) {
+            index[i] = i;
+        }
+        // Compared as the mesh will store them: rounding to float or int can make points
+        // equal or swap their y. Equal points stay in input order, for any number of threads.
+        auto less = [points](int a, int b) {
+            const Point pa(points[a]), pb(points[b]);
+            return DivideAndConquer<Real>::Less(pa, pb) || (!DivideAndConquer<Real>::Less(pb, pa) && a < b);
+        };
+        DivideAndConquer<Real>::Sort(index.begin(), index.end(), less, numThreads);
+    }
+    mesh->duplicates.clear();
+    vector<int> unique;
+    {
+        ScopedPhase phase("Copy");
+        mesh->verts.resize(count);
+        unique.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            mesh->verts[i] = Point(points[index[i]]);
+            if (unique.empty() || DivideAndConquer<Real>::Less(mesh->verts[unique.back()], mesh->verts[i])) {
+                unique.push_back(i);
+            }
         }
     }
+    DivideAndConquer<Real>(mesh->verts.data(), unique).Run(mesh, numThreads);
+    // Equal points are next to each other, after the one that went into the mesh.
+    for (int u = 0, i = 0; i < count; ++i) {
+        if (u < (int) unique.size() && unique[u] == i) {
+            u++;
+        } else {
+            mesh->AddDuplicate(unique[u - 1], i);
+        }
+    }
+    MESH_STAT(mesh->stats.edgesAllocated += mesh->edges.size());
+}
 
-    Vec b(center.x, center.y + radius + epsilon); // Top-most point in the triangle.
-    double const sin45 = 0.707106781; // cos(pi/4) = sin(pi/4) = sqrt(2)/2
+template<class Real>
+/*static*/BasicMesh<Real> BasicMesh<Real>::GenerateDivideAndConquer(const vector<Vec> &verts, int numThreads) {
+    BasicMesh result;
+    GenerateDivideAndConquer(verts.data(), verts.size(), &result, NULL, numThreads);
+    return result;
+}
 
-    // Direction vector from b to a.
-    Vec dir = Vec(radius * sin45, radius * (sin45 - 1) - epsilon);//.Normalize();
+template<class Real>
+void BasicMesh<Real>::Rebuild(const Vec *points, int count, InsertionOrder order) {
+    Generate(points, count, this, NULL, order);
+}
 
-    // The magnitude of the vector from b to a
-    const double scale = -2 * (radius + epsilon) / dir.y;
+template<class Real>
+void BasicMesh<Real>::Clear() {
+    verts.clear();
+    edges.clear();
+    incident.clear();
+    duplicates.clear();
+    locateHint = 0;
+    ghostIncident = -1;
+}
 
-    // Displacement in x from center to a.
-    const double ax = b.x + dir.x * scale;
+template<class Real>
+int BasicMesh<Real>::Insert(const Point &v) {
+    assert(InRange(v));
+    const int iVec = verts.size();
+    verts.push_back(v);
+    incident.push_back(-1);
+    if (GetNumFaces() == 0) {
+        // Nothing to walk on yet. Small or collinear sets are cheap to redo.
+        Triangulate();
+        return iVec;
+    }
+    const int inserted = InsertVertex(iVec);
+    if (inserted != iVec) {
+        verts.pop_back();
+        incident.pop_back();
+    }
+    return inserted;
+}
 
-    Vec a(center.x + ax, center.y - radius - epsilon);
+template<class Real>
+int BasicMesh<Real>::Insert(const Vec &v) {
+    assert(InRange(v));
+    return Insert(Point(v));
+}
 
-    // Vector c is reflected along the y axis at the center.
-    Vec c(center.x - ax, a.y);
+template<class Real>
+void BasicMesh<Real>::Insert(vector<Vec>::const_iterator begin, vector<Vec>::const_iterator end) {
+    ScopedPhase phase("InsertBatch");
+    for (vector<Vec>::const_iterator it = begin; it != end; ++it) {
+        assert(InRange(*it));
+    }
+    // Duplicates are kept as isolated vertices here so that indices follow the input.
+    const int first = verts.size();
+    Reserve(first + (end - begin));
+    verts.insert(verts.end(), begin, end);
+    incident.resize(verts.size(), -1);
+    if (GetNumFaces() == 0) {
+        Triangulate();
+        return;
+    }
+    for (int iVec = first; iVec < (int) verts.size(); ++iVec) {
+        const int inserted = InsertVertex(iVec);
+        if (inserted != iVec) {
+            AddDuplicate(inserted, iVec);
+        }
+    }
+}
+
+template<class Real>
+void BasicMesh<Real>::Reserve(int numVerts) {
+    verts.reserve(numVerts);
+    incident.reserve(numVerts);
+    // Euler: 2n - 2 faces, ghosts included.
+    edges.reserve(3 * max(1, 2 * numVerts - 2));
+    // Usually a handful deep; they keep whatever they grow to.
+    flipStack.reserve(64);
+    starScratch.reserve(64);
+}
 
-    vector<Vec> res;
-    res.push_back(a);
-    res.push_back(b);
-    res.push_back(c);
+template<class Real>
+void BasicMesh<Real>::Triangulate() {
+    ScopedPhase phase("Triangulate");
+    edges.clear();
+    duplicates.clear();
+    locateHint = 0;
+    ghostIncident = -1;
+    const int n = verts.size();
+    incident.assign(n, -1);
+    Reserve(n);
 
-    return res;
+    // First face : ==========
+    // The first three points that are not collinear.
+    int a = 0, b = 1, c;
+    while (b < n && verts[b].x == verts[a].x && verts[b].y == verts[a].y) {
+        b++;
+    }
+    for (c = b + 1; c < n; ++c) {
+        const double det = Predicates::Orient2d(verts[a], verts[b], verts[c]);
+        if (det != 0) {
+            if (det < 0) {
+                swap(b, c);
+            }
+            break;
+        }
+    }
+    if (c >= n) {
+        return; // Everything is on a line.
+    }
+    edges.resize(3);
+    MESH_STAT(stats.edgesAllocated += 3);
+    SetFace(0, a, b, c);
+    AddGhostFaces();
+    //========================
+
+    // Insert the rest: locate, split and flips, one point at a time.
+    ScopedPhase insertPhase("InsertLoop");
+    for (int iVec = 0; iVec < n; iVec++) {
+        if (iVec != a && iVec != b && iVec != c) {
+            const int inserted = InsertVertex(iVec);
+            if (inserted != iVec) {
+                AddDuplicate(inserted, iVec);
+            }
+        }
+    }
 }
 
-void Mesh::SplitFace(int faceIndex, int vecIndex) {
-    // indices of the triangle
-    const int e[3] = { faceIndex, edges[faceIndex].next, edges[edges[faceIndex].next].next };
+template<class Real>
+int BasicMesh<Real>::InsertVertex(int iVec) {
+    const Point &v = verts[iVec];
+    const int iFace = FaceOf(Walk(v));
+    if (!IsGhost(iFace)) {
+        for (int e = 3 * iFace; e < 3 * iFace + 3; ++e) {
+            const Point &corner = verts[edges[e].point];
+            if (corner.x == v.x && corner.y == v.y) {
+                return edges[e].point;
+            }
+        }
+    }
+    // Outside of the hull this splits a ghost face, and the flips connect the point to
+    // every hull edge it can see. On a hull edge the flat face is flipped with its ghost.
+    SplitFace(iFace, iVec);
+    return iVec;
+}
 
-    // Check if it is a triangle
-    assert(edges[edges[e[2]].next] == edges[e[0]]);
+/*
+ * The faces around the vertex are cut out and the hole, bounded by the link of the
+ * vertex, is filled again by Delaunay ear clipping (Devillers, "On deletion in Delaunay
+ * triangulations"): three consecutive vertices of the link make a face of the new
+ * triangulation if they turn counter-clockwise and no other vertex of the link is inside
+ * their circle. Such an ear always exists, collinear and cocircular neighbours included,
+ * so the hole is filled without flips and the rest of the mesh is not touched.
+ * On the hull the link goes through the ghost. Once no real ear is left, what remains
+ * of the link is the new hull, and it gets a fan of ghost faces.
+ */
+template<class Real>
+int BasicMesh<Real>::Remove(int vertexId) {
+    if (incident[vertexId] < -1) {
+        ForgetDuplicate(vertexId);
+        return RemoveIndex(vertexId);
+    }
+    const typename DuplicateMap::iterator dup = duplicates.find(vertexId);
+    if (dup != duplicates.end()) {
+        // A duplicate is left at the same point: it takes over the faces as they are.
+        const int promoted = dup->second;
+        duplicates.erase(dup);
+        IndexVector &star = starScratch;
+        VertexEdges(vertexId, &star);
+        for (int ei : star) {
+            edges[ei].point = promoted;
+        }
+        incident[promoted] = incident[vertexId];
+        incident[vertexId] = -1;
+        MoveDuplicates(vertexId, promoted);
+        return RemoveIndex(vertexId);
+    }
+    if (incident[vertexId] < 0) {
+        // In no face: everything is on a line.
+        return RemoveIndex(vertexId);
+    }
+    const int ghost = (int) HalfEdgeProperties::GHOST;
+    IndexVector star(GetResource());
+    VertexEdges(vertexId, &star);
+    const int d = star.size();
+
+    // The link, counter-clockwise around the hole. The star goes clockwise, and the
+    // outer edge of the face of star[i] goes from the origin of star[i + 1] to the origin
+    // of star[i]. side[k] is the edge on the other side of link[k] -> link[k + 1].
+    IndexVector link(d, 0, GetResource());
+    IndexVector side(d, 0, GetResource());
+    for (int k = 0; k < d; ++k) {
+        const int i = d - 1 - k;
+        link[k] = edges[Prev(star[i])].point;
+        side[k] = edges[Prev(star[i == 0 ? d - 1 : i - 1])].twin;
+    }
+    const int g = find(link.begin(), link.end(), ghost) - link.begin();
+    const bool hull = g < d;
+    if (hull) {
+        // The ghost goes first, so the new hull runs from link[1] to the end.
+        rotate(link.begin(), link.begin() + g, link.end());
+        rotate(side.begin(), side.begin() + g, side.end());
+    }
 
-    const int edgeI = edges.size();
+    // Clipping order, worked out before the mesh changes. The link is a ring in
+    // prev / next; original[k] tells if link[k] -> next[k] is still an edge of the link.
+    IndexVector next(d, 0, GetResource());
+    IndexVector prev(d, 0, GetResource());
+    IndexVector original(d, 1, GetResource());
+    IndexVector tips(GetResource());
+    for (int k = 0; k < d; ++k) {
+        next[k] = (k + 1) % d;
+        prev[k] = (k + d - 1) % d;
+    }
+    int left = d;
+    int k = hull ? 1 : 0;
+    for (int misses = 0; left > 3 && misses < left;) {
+        if (IsDelaunayEar(link, prev[k], k, next[k])) {
+            tips.push_back(k);
+            original[prev[k]] = 0;
+            next[prev[k]] = next[k];
+            prev[next[k]] = prev[k];
+            left--;
+            misses = 0;
+            k = prev[k];
+        } else {
+            misses++;
+            k = next[k];
+        }
+    }
+    assert(hull || left == 3);
+    if (hull) {
+        // The fan. A hull edge that already has a ghost face on its other side would
+        // be left with no face at all: the remaining points are all on a line.
+        for (int x = next[0]; next[x] != 0; x = next[x]) {
+            if (original[x] && IsGhost(FaceOf(side[x]))) {
+                const int moved = RemoveIndex(vertexId);
+                Triangulate();
+                return moved;
+            }
+        }
+        while (left > 3) {
+            const int tip = next[0];
+            tips.push_back(tip);
+            next[0] = next[tip];
+            prev[next[tip]] = 0;
+            left--;
+        }
+        k = 0;
+    }
 
-    // Create 6 new half edges.
-    for (int i = 0; i < 6; ++i) {
-        edges.push_back(HalfEdge());
+    // Replay the clipping into the faces of the star, lowest first. Clipping the ear
+    // (a, b, c) makes the face (a, b, c), whose edge c -> a is the side of a -> c.
+    IndexVector faces(d, 0, GetResource());
+    for (int i = 0; i < d; ++i) {
+        faces[i] = FaceOf(star[i]);
+    }
+    sort(faces.begin(), faces.end());
+    for (int i = 0; i < d; ++i) {
+        next[i] = (i + 1) % d;
+        prev[i] = (i + d - 1) % d;
     }
-    // new edges and their twins.
-    const int n[3] = { edgeI, edgeI + 1, edgeI + 2 };
-    const int tn[3] = { edgeI + 3, edgeI + 4, edgeI + 5 };
+    int numFaces = 0;
+    for (int tip : tips) {
+        const int a = prev[tip], c = next[tip];
+        const int f = faces[numFaces++];
+        SetFace(f, link[a], link[tip], link[c]);
+        Link(3 * f + 1, side[a]);
+        Link(3 * f + 2, side[tip]);
+        side[a] = 3 * f;
+        next[a] = c;
+        prev[c] = a;
+    }
+    const int f = faces[numFaces++];
+    SetFace(f, link[k], link[next[k]], link[prev[k]]);
+    Link(3 * f + 1, side[k]);
+    Link(3 * f + 2, side[next[k]]);
+    Link(3 * f, side[prev[k]]);
+    assert(numFaces == d - 2);
+
+    // The two faces left over go, with what still points into them.
+    incident[vertexId] = -1;
+    locateHint = 3 * faces[0];
+    for (int i = d - 1; i >= d - 2; --i) {
+        for (int ei = 3 * faces[i]; ei < 3 * faces[i] + 3; ++ei) {
+            edges[ei].twin = (int) HalfEdgeProperties::NO_TWIN;
+        }
+        RemoveFace(faces[i]);
+    }
+    return RemoveIndex(vertexId);
+}
 
-    for (int i = 0; i < 3; ++i) {
-        edges[n[i]].point = edges[e[i]].point;
-        edges[n[i]].next = e[(i + 1) % 3];
-        edges[n[i]].twin = tn[i];
+/*
+ * The other vertices of the link are the only ones that matter: the circle of a face
+ * of the hole can't reach past the faces around it, which were Delaunay with the vertex.
+ */
+template<class Real>
+bool BasicMesh<Real>::IsDelaunayEar(const IndexVector &link, int a, int b, int c) const {
+    const int ghost = (int) HalfEdgeProperties::GHOST;
+    if (link[a] == ghost || link[b] == ghost || link[c] == ghost) {
+        return false;
+    }
+    const Point &pa = verts[link[a]];
+    const Point &pb = verts[link[b]];
+    const Point &pc = verts[link[c]];
+    MESH_STAT(stats.orientationTests++);
+    if (Predicates::Orient2d(pa, pb, pc) <= 0) {
+        return false;
+    }
+    for (int k = 0; k < (int) link.size(); ++k) {
+        if (k != a && k != b && k != c && link[k] != ghost) {
+            MESH_STAT(stats.incircleTests++);
+            if (Predicates::InCirclePerturbed(pa, pb, pc, verts[link[k]]) > 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
 
-        edges[tn[i]].point = vecIndex;
-        edges[tn[i]].next = n[(i + 2) % 3];
-        edges[tn[i]].twin = n[i];
+template<class Real>
+int BasicMesh<Real>::RemoveIndex(int vertexId) {
+    const int last = verts.size() - 1;
+    if (vertexId != last) {
+        IndexVector &star = starScratch;
+        VertexEdges(last, &star);
+        for (int ei : star) {
+            edges[ei].point = vertexId;
+        }
+        verts[vertexId] = verts[last];
+        incident[vertexId] = incident[last];
+        if (incident[last] < -1) {
+            const int vertex = -2 - incident[last];
+            ForgetDuplicate(last);
+            AddDuplicate(vertex, vertexId);
+        } else {
+            MoveDuplicates(last, vertexId);
+        }
+    }
+    verts.pop_back();
+    incident.pop_back();
+    return last;
+}
 
-        edges[e[i]].next = tn[i];
+template<class Real>
+void BasicMesh<Real>::AddDuplicate(int vertex, int dup) {
+    duplicates.insert(make_pair(vertex, dup));
+    incident[dup] = -2 - vertex;
+}
+
+template<class Real>
+void BasicMesh<Real>::ForgetDuplicate(int dup) {
+    const pair<typename DuplicateMap::iterator, typename DuplicateMap::iterator> range =
+            duplicates.equal_range(-2 - incident[dup]);
+    for (typename DuplicateMap::iterator it = range.first; it != range.second; ++it) {
+        if (it->second == dup) {
+            duplicates.erase(it);
+            break;
+        }
     }
-    // Add the extra faces.
-    // e[0] is the original face. The other two sides now represent the new faces.
-    faces.insert(e[1]);
-    faces.insert(e[2]);
-    for (int i = 0; i < 3; i++) {
-        SwapEdge(e[i]);
+    incident[dup] = -1;
+}
+
+template<class Real>
+void BasicMesh<Real>::MoveDuplicates(int from, int to) {
+    // Inserting can rehash, so look again each time.
+    for (typename DuplicateMap::iterator it = duplicates.find(from); it != duplicates.end();
+            it = duplicates.find(from)) {
+        const int dup = it->second;
+        duplicates.erase(it);
+        AddDuplicate(to, dup);
     }
 }
 
-void Mesh::SwapEdge(int ei) {
+template<class Real>
+void BasicMesh<Real>::SplitFace(int faceIndex, int vecIndex) {
+    // Points of the triangle. Edge 3f + i ends at p[i].
+    const int e0 = 3 * faceIndex;
+    const int p[3] = { edges[e0].point, edges[e0 + 1].point, edges[e0 + 2].point };
+    // Outer twins of the edges that move to the new faces.
+    const int t1 = edges[e0 + 1].twin;
+    const int t2 = edges[e0 + 2].twin;
+
+    // Two new faces. faceIndex keeps the edge ending at p[0].
+    const int f1 = GetNumFaces();
+    const int f2 = f1 + 1;
+    edges.resize(edges.size() + 6);
+    MESH_STAT(stats.edgesAllocated += 6);
+
+    SetFace(faceIndex, p[0], vecIndex, p[2]);
+    SetFace(f1, p[1], vecIndex, p[0]);
+    SetFace(f2, p[2], vecIndex, p[1]);
+
+    Link(3 * f1, t1);
+    Link(3 * f2, t2);
+    Link(e0 + 1, 3 * f1 + 2);
+    Link(e0 + 2, 3 * f2 + 1);
+    Link(3 * f1 + 1, 3 * f2 + 2);
+
+    // The next point will most likely land close to this one.
+    locateHint = e0;
+    SwapEdge(e0);
+    SwapEdge(3 * f1);
+    SwapEdge(3 * f2);
+}
+
+template<class Real>
+void BasicMesh<Real>::SwapEdge(int ei) {
     // Edge stack to avoid recursion.
-    vector<int> stack;
+    IndexVector &stack = flipStack;
+    stack.clear();
     stack.push_back(ei);
     while(!stack.empty()){
         const int edgeIndex = stack.back();
         stack.pop_back();
-        const int vecIndex = edges[edges[edgeIndex].next].point;
-        HalfEdge *edge = &edges.at(edgeIndex);
-        if (edge->twin == (int) HalfEdgeProperties::NO_TWIN) {
-            return; // This edge is adjacent to the infinite face.
+        const int twinIndex = edges[edgeIndex].twin;
+        if (twinIndex == (int) HalfEdgeProperties::NO_TWIN) {
+            continue; // Only while a face is being cut out.
         }
 
-        Vec origin = verts[edges[edge->next].point];
-        Vec toChange = verts[edges[edges[edge->twin].next].point];
-
         // If it is inside a circumcircle then swap.
-        if (IsInsideCircumcircle(&toChange, edge)) {
-            int a, b, c, d;
-
-            // The edge to swap and its twin
-            HalfEdge *e = &edges.at(edgeIndex);
-            HalfEdge *et = &edges[e->twin];
-
-            // Get the two faces
-            int f1, f2;
-            f1 = FindFace(edgeIndex);
-            f2 = FindFace(edges[edgeIndex].twin);
-
-            //Set up the quad
-            b = et->next;
-            c = edges[b].next;
-            d = e->next;
-            a = edges[d].next;
-
-            // Change the points of the edge (i.e. Swap)
-            e->point = edges[d].point;
-            et->point = edges[b].point;
-            e->next = a;
-            et->next = c;
-
-            // Reflect change in topology
-            edges[a].next = b;
-            edges[b].next = edgeIndex;
-            edges[c].next = d;
-            edges[d].next = e->twin;
-
-            // Change faces.
-            faces.erase(f1);
-            faces.erase(f2);
-            faces.insert(edgeIndex);
-            faces.insert(e->twin);
+        if (IsInsideCircumcircle(edges[Next(twinIndex)].point, FaceOf(edgeIndex))) {
+            Flip(edgeIndex);
+            MESH_STAT(stats.flips++);
 
             // Add edges that now may be invalid (the quad.)
-            stack.push_back(a);
-            stack.push_back(b);
-            stack.push_back(c);
-            stack.push_back(d);
+            stack.push_back(Next(edgeIndex));
+            stack.push_back(Prev(edgeIndex));
+            stack.push_back(Next(twinIndex));
+            stack.push_back(Prev(twinIndex));
+            MESH_STAT(stats.maxFlipStack = max(stats.maxFlipStack, (int) stack.size()));
         }
     }
 }
 
 /*
- * O(n)
- * Doing a linear search is not an issue (profiling). Most of the time will not be spent here for any
- * reasonable number of points for this application.
- * Normal usage has ~16% time of mesh generation here, and ~76% in the SplitFace method.
- * (or ~27% vs 66% if we are using hash_set or unordered_set).
+ * The edge A->B of face (A, B, C) and its twin in face (B, A, D) are replaced by C->D.
+ * Both faces are rewritten in place: (A, D, C) and (D, B, C).
  */
-int Mesh::GetContainingFace(int iVec) {
-    Vec *vec = &verts[iVec];
-    for (int iFace : faces) {
-        HalfEdge *e1 = &edges[iFace];
-        if (IsInsideTriangle(vec, e1)) {
-            return iFace;
-        }
-    }
-    //todo: Error.
-    return -1;
+template<class Real>
+void BasicMesh<Real>::Flip(int edgeIndex) {
+    const int twinIndex = edges[edgeIndex].twin;
+    // Slots of both faces.
+    const int n1 = Next(edgeIndex), n2 = Prev(edgeIndex);
+    const int m1 = Next(twinIndex), m2 = Prev(twinIndex);
+
+    const int a = edges[n2].point;
+    const int b = edges[edgeIndex].point;
+    const int c = edges[n1].point;
+    const int d = edges[m1].point;
+
+    // Outer twins of the quad: B->C, C->A, A->D, D->B.
+    const int tbc = edges[n1].twin;
+    const int tca = edges[n2].twin;
+    const int tad = edges[m1].twin;
+    const int tdb = edges[m2].twin;
+
+    // Change the points of the edge (i.e. Swap)
+    // edgeIndex and twinIndex become the new diagonal.
+    edges[edgeIndex].point = c;
+    edges[n1].point = a;
+    edges[n2].point = d;
+    edges[twinIndex].point = d;
+    edges[m1].point = b;
+    edges[m2].point = c;
+    SetIncident(a, n1);
+    SetIncident(b, m1);
+    SetIncident(c, edgeIndex);
+    SetIncident(d, n2);
+
+    // Reflect change in topology
+    Link(n1, tca);
+    Link(n2, tad);
+    Link(m1, tdb);
+    Link(m2, tbc);
 }
 
-// ====
-// Helper functions to determine if a face is inside a triangle
-inline double BarycentricDet(Vec *a, Vec *b, Vec *c) {
-    return (b->x - a->x) * (c->y - a->y) - (c->x - a->x) * (b->y - a->y);
-}
-
-/**
- *
- * @param v
- * @param a, b, c Base triangle
- * @return v in barycentric coordinates relative to the triangle.
+/*
+ * Visibility walk. Starting from the face that was split last, cross any edge that
+ * has the point strictly to its right until no such edge is left, or until the walk
+ * steps out of the hull into a ghost face.
+ * Expected O(sqrt(n)) steps for random insertion order, much less for spatially sorted input.
+ * It always terminates on a Delaunay triangulation, which is what we have between insertions.
  */
-inline Vec ToBarycentric2d(Vec *v, Vec *a, Vec *b, Vec *c) {
-    Vec res;
+template<class Real>
+int BasicMesh<Real>::Walk(const Point &v) const {
+    return Walk(edges.data(), verts.data(), locateHint, v, &stats);
+}
 
-    double A = BarycentricDet(a, b, c);
-    if (A == 0) {
-        cerr << "Called ToBarycentric2d with a triangle of area 0\n";
-        exit(-1);
+template<class Real>
+/*static*/int BasicMesh<Real>::Walk(const HalfEdge *edges, const Point *verts, int ei, const Point &v, Stats *stats) {
+    (void) stats; // Only counted into with MESH_STATS.
+    if (IsGhost(edges, FaceOf(ei))) {
+        ei = edges[RealEdge(edges, FaceOf(ei))].twin;
+    }
+    int entry = (int) HalfEdgeProperties::NO_TWIN;
+    MESH_STAT(if (stats != NULL) stats->locates++);
+    for (;;) {
+        int crossed = (int) HalfEdgeProperties::NO_TWIN;
+        // Test the edges of the current face. The one we came through is known to be fine.
+        for (int i = 0; i < 3; ++i, ei = Next(ei)) {
+            if (ei == entry) {
+                continue;
+            }
+            MESH_STAT(if (stats != NULL) stats->orientationTests++);
+            if (Predicates::Orient2d(verts[edges[Prev(ei)].point], verts[edges[ei].point], v) < 0) {
+                crossed = ei;
+                break;
+            }
+        }
+        if (crossed == (int) HalfEdgeProperties::NO_TWIN) {
+            return ei;
+        }
+        entry = edges[crossed].twin;
+        MESH_STAT(if (stats != NULL) stats->locateSteps++);
+        if (IsGhost(edges, FaceOf(entry))) {
+            // Outside of the convex hull.
+            return entry;
+        }
+        ei = entry;
     }
-
-    res.x = BarycentricDet(v, b, c) / A;
-    res.y = BarycentricDet(a, b, v) / A;
-    res.z = 1 - res.x - res.y;
-
-    return res;
 }
-// ===
 
-bool Mesh::IsInsideTriangle(Vec *v, Face f) {
-    Vec *a, *b, *c;
-    a = &verts[f->point];
-    b = &verts[edges[f->next].point];
-    c = &verts[edges[edges[f->next].next].point];
-    Vec bar = ToBarycentric2d(v, a, b, c);
-    return bar.x <= 1 && bar.y <= 1 && bar.z <= 1 && bar.x >= 0 && bar.y >= 0 && bar.z >= 0;
+template<class Real>
+int BasicMesh<Real>::Locate(const Point &v) const {
+    if (GetNumFaces() == 0) {
+        return -1;
+    }
+    const int face = FaceOf(Walk(v));
+    return IsGhost(face) ? -1 : face;
 }
 
-//todo: test IsInsideCircumcircle
-bool Mesh::IsInsideCircumcircle(Vec *v, Face t) {
-    // Compute the determinant..
-    Vec *a = &verts[t->point];
-    Vec *b = &verts[edges[t->next].point];
-    Vec *c = &verts[edges[edges[t->next].next].point];
-
-
-    const double t1 = a->x*a->x - v->x*v->x + a->y*a->y - v->y*v->y;
-    const double t2 = b->x*b->x - v->x*v->x + b->y*b->y - v->y*v->y;
-    const double t3 = c->x*c->x - v->x*v->x + c->y*c->y - v->y*v->y;
-
-    const double det =
-            (a->x - v->x) * ((b->y - v->y) * t3
-            - (c->y - v->y) * t2)
-            + (a->y - v->y) * ((c->x - v->x) * t2
-            - (b->x - v->x) * t3)
-            + t1 * ((b->x - v->x) * (c->y - v->y)
-            - (b->y - v->y) * (c->x - v->x));
+template<class Real>
+bool BasicMesh<Real>::IsGhost(int faceIndex) const {
+    return IsGhost(edges.data(), faceIndex);
+}
 
-    return det > 0;
+template<class Real>
+/*static*/bool BasicMesh<Real>::IsGhost(const HalfEdge *edges, int faceIndex) {
+    const HalfEdge *e = &edges[3 * faceIndex];
+    return e[0].point == (int) HalfEdgeProperties::GHOST || e[1].point == (int) HalfEdgeProperties::GHOST
+            || e[2].point == (int) HalfEdgeProperties::GHOST;
+}
 
-    // Other impl: ==============================================
-    // 4x4 matrix determinant.
-    const double a1 = a->x;
-    const double a2 = b->x;
-    const double a3 = c->x;
-    const double a4 = v->x;
+template<class Real>
+void BasicMesh<Real>::GetHull(vector<int> *hull) const {
+    hull->clear();
+    if (GetNumFaces() == 0) {
+        return;
+    }
+    // Ghost faces (x, ghost, y) around the ghost vertex: x -> y is a hull edge.
+    int ei = ghostIncident;
+    do {
+        hull->push_back(edges[Prev(ei)].point);
+        ei = edges[Next(ei)].twin;
+    } while (ei != ghostIncident);
+}
 
-    const double b1 = a->y;
-    const double b2 = b->y;
-    const double b3 = c->y;
-    const double b4 = v->y;
+template<class Real>
+int BasicMesh<Real>::RealEdge(int faceIndex) const {
+    return RealEdge(edges.data(), faceIndex);
+}
 
-    const double c1 = a1*a1 + b1*b1;
-    const double c2 = a2*a2 + b2*b2;
-    const double c3 = a3*a3 + b3*b3;
-    const double c4 = a4*a4 + b4*b4;
+template<class Real>
+/*static*/int BasicMesh<Real>::RealEdge(const HalfEdge *edges, int faceIndex) {
+    int ei = 3 * faceIndex;
+    while (edges[ei].point != (int) HalfEdgeProperties::GHOST) {
+        ei++;
+    }
+    // The edge after the one ending at the ghost starts there, the one before is real.
+    return Prev(ei);
+}
 
-    const double d1 = 1, d2 = 1, d3 = 1, d4 = 1;
+template<class Real>
+double BasicMesh<Real>::Orientation(int edgeIndex, const Point &v) const {
+    MESH_STAT(stats.orientationTests++);
+    const Point &from = verts[edges[Prev(edgeIndex)].point];
+    const Point &to = verts[edges[edgeIndex].point];
+    return Predicates::Orient2d(from, to, v);
+}
 
-    const double det1 = a1*b2*c3*d4 - a1*b2*c4*d3 + a1*b3*c4*d2 - a1*b3*c2*d4
-                     + a1*b4*c2*d3 - a1*b4*c3*d2 - a2*b3*c4*d1 + a2*b3*c1*d4
-                     - a2*b4*c1*d3 + a2*b4*c3*d1 - a2*b1*c3*d4 + a2*b1*c4*d3
-                     + a3*b4*c1*d2 - a3*b4*c2*d1 + a3*b1*c2*d4 - a3*b1*c4*d2
-                     + a3*b2*c4*d1 - a3*b2*c1*d4 - a4*b1*c2*d3 + a4*b1*c3*d2
-                     - a4*b2*c3*d1 + a4*b2*c1*d3 - a4*b3*c1*d2 + a4*b3*c2*d1;
+template<class Real>
+bool BasicMesh<Real>::IsInsideTriangle(const Point &v, Face f) {
+    const int ei = f - edges.data();
+    const Point &a = verts[f->point];
+    const Point &b = verts[edges[Next(ei)].point];
+    const Point &c = verts[edges[Prev(ei)].point];
+    MESH_STAT(stats.orientationTests += 3);
+    return Predicates::Orient2d(a, b, v) >= 0 && Predicates::Orient2d(b, c, v) >= 0
+            && Predicates::Orient2d(c, a, v) >= 0;
+}
 
-    return det1 > 0;
+/*
+ * Ghost faces follow Shewchuk's rules: the circumcircle of a ghost face is the open
+ * half plane on the outer side of its real edge, and the ghost vertex is never inside
+ * the circle of a real face, unless that face is flat.
+ * Cocircular points are inside or outside by symbolic perturbation, never on the circle,
+ * so the mesh of a grid does not depend on the insertion order.
+ */
+template<class Real>
+bool BasicMesh<Real>::IsInsideCircumcircle(int vecIndex, int faceIndex) const {
+    MESH_STAT(stats.incircleTests++);
+    const int e0 = 3 * faceIndex;
+    if (vecIndex == (int) HalfEdgeProperties::GHOST) {
+        if (IsGhost(faceIndex)) {
+            return false;
+        }
+        return Predicates::Orient2d(verts[edges[e0].point], verts[edges[e0 + 1].point],
+                verts[edges[e0 + 2].point]) == 0;
+    }
+    const Point &v = verts[vecIndex];
+    if (IsGhost(faceIndex)) {
+        const int real = RealEdge(faceIndex);
+        return Orientation(real, v) > 0;
+    }
+    const Point &a = verts[edges[e0].point];
+    const Point &b = verts[edges[e0 + 1].point];
+    const Point &c = verts[edges[e0 + 2].point];
+    return Predicates::InCirclePerturbed(a, b, c, v) > 0;
 }
 
-void Mesh::RemoveFace(int face) {
-    if(!faces.count(face)){
+template<class Real>
+void BasicMesh<Real>::RemoveFace(int face) {
+    if (face < 0 || face >= GetNumFaces()) {
         return;
     }
-    HalfEdge *edge = &edges[face];
-    int ei = face;
-    do{
-        // Virtually erase the edge.
-        if(edge->twin != (int) HalfEdgeProperties::NO_TWIN){
-            edges[edge->twin].twin = (int)HalfEdgeProperties::NO_TWIN;
+    // Vertices that only knew this face look for another one.
+    for (int ei = 3 * face; ei < 3 * face + 3; ++ei) {
+        const int p = edges[ei].point;
+        if (Incident(p) >= 0 && FaceOf(Incident(p)) == face) {
+            SetIncident(p, OtherIncident(ei));
         }
-        //edges[ei] = HalfEdge();
-        ei = edges[ei].next;
-    }while(ei!=face);
-    faces.erase(face);
+    }
+    // Virtually erase the edges.
+    for (int ei = 3 * face; ei < 3 * face + 3; ++ei) {
+        if (edges[ei].twin != (int) HalfEdgeProperties::NO_TWIN) {
+            edges[edges[ei].twin].twin = (int) HalfEdgeProperties::NO_TWIN;
+        }
+    }
+    // Move the last face into the hole.
+    const int last = GetNumFaces() - 1;
+    if (face != last) {
+        for (int i = 0; i < 3; ++i) {
+            const int from = 3 * last + i;
+            const int to = 3 * face + i;
+            edges[to].point = edges[from].point;
+            Link(to, edges[from].twin);
+            if (Incident(edges[to].point) == from) {
+                SetIncident(edges[to].point, to);
+            }
+        }
+        if (FaceOf(locateHint) == last) {
+            locateHint = 3 * face + locateHint % 3;
+        }
+    }
+    edges.resize(3 * last);
+    if (FaceOf(locateHint) >= last) {
+        locateHint = 0;
+    }
+}
 
+template<class Real>
+int BasicMesh<Real>::OtherIncident(int edgeIndex) const {
+    const int face = FaceOf(edgeIndex);
+    // One way around the vertex...
+    for (int ei = edges[Next(edgeIndex)].twin; ei != (int) HalfEdgeProperties::NO_TWIN && ei != edgeIndex;
+            ei = edges[Next(ei)].twin) {
+        if (FaceOf(ei) != face) {
+            return ei;
+        }
+    }
+    // ...and the other, if the first one hit the hull.
+    for (int ei = edges[edgeIndex].twin; ei != (int) HalfEdgeProperties::NO_TWIN; ) {
+        ei = Prev(ei);
+        if (ei == edgeIndex) {
+            break;
+        }
+        if (FaceOf(ei) != face) {
+            return ei;
+        }
+        ei = edges[ei].twin;
+    }
+    return -1;
 }
 
-// O(logn)
-int Mesh::FindFace(int edgeIndex) {
-    int i = edgeIndex;
+template<class Real>
+void BasicMesh<Real>::VertexEdges(int vertex, IndexVector *star) const {
+    star->clear();
+    const int start = incident[vertex];
+    if (start < 0) {
+        return;
+    }
+    int ei = start;
     do {
-        if(faces.count(i)) {
-            return i;
+        star->push_back(ei);
+        ei = edges[Next(ei)].twin;
+    } while (ei != start);
+}
+
+template<class Real>
+void BasicMesh<Real>::SetFace(int face, int p0, int p1, int p2) {
+    HalfEdge *e = &edges[3 * face];
+    e[0].point = p0;
+    e[1].point = p1;
+    e[2].point = p2;
+    SetIncident(p0, 3 * face);
+    SetIncident(p1, 3 * face + 1);
+    SetIncident(p2, 3 * face + 2);
+}
+
+/*
+ * Hull edges are the ones without a twin. Each one gets a ghost face (x, ghost, y)
+ * for its twin y -> x, and the ghost faces are then linked to each other around the
+ * ghost vertex.
+ */
+template<class Real>
+void BasicMesh<Real>::AddGhostFaces() {
+    const int numReal = GetNumFaces();
+    for (int ei = 0; ei < 3 * numReal; ++ei) {
+        if (edges[ei].twin == (int) HalfEdgeProperties::NO_TWIN) {
+            const int f = GetNumFaces();
+            edges.resize(edges.size() + 3);
+            MESH_STAT(stats.edgesAllocated += 3);
+            SetFace(f, edges[Prev(ei)].point, (int) HalfEdgeProperties::GHOST, edges[ei].point);
+            Link(3 * f, ei);
         }
-        i = edges[i].next;
-    } while(i!=edgeIndex);
-    //todo: error
-    return -1;
+    }
+    // Now each hull vertex y has its edge ghost -> y as the incident one.
+    for (int f = numReal; f < GetNumFaces(); ++f) {
+        SetIncident(edges[3 * f + 2].point, 3 * f + 2);
+    }
+    for (int f = numReal; f < GetNumFaces(); ++f) {
+        Link(3 * f + 1, incident[edges[3 * f].point]);
+    }
 }
+
+template<class Real>
+void BasicMesh<Real>::Link(int e1, int e2) {
+    edges[e1].twin = e2;
+    if (e2 != (int) HalfEdgeProperties::NO_TWIN) {
+        edges[e2].twin = e1;
+    }
+}
+
+template class BasicMesh<float>;
+template class BasicMesh<double>;
+template class BasicMesh<int32_t>;
@@ -22,24 +22,215 @@
 #ifndef MESH_H_
 #define MESH_H_
 
+#include <unordered_map>
+
 #include "common.h"
+#include "Arena.h"
 #include "Entity.h"
+#include "SpatialSort.h"
 
 //class MeshTest;
+class MappedPoints;
+template<class Real> class DivideAndConquer;
+
+/**
+ * Hot path counters, see BasicMesh::GetStats. They only move in builds with MESH_STATS defined
+ * (mode=debug); otherwise the counting code is compiled out and they stay at 0.
+ */
+struct MeshStats {
+    long orientationTests;  // Point against edge, in Walk and IsInsideTriangle.
+    long incircleTests;     // IsInsideCircumcircle, ghost faces included.
+    long flips;             // Flips done by SwapEdge.
+    int maxFlipStack;       // Deepest SwapEdge stack.
+    long locates;           // Walks, one per insertion plus one per Locate.
+    long locateSteps;       // Faces crossed by those walks.
+    long edgesAllocated;    // Half edges ever appended to the mesh.
+    // Not counters, filled in by GetStats in every build.
+    long edgesLive;         // Half edges of the current faces, ghosts included.
+    long edgesCapacity;     // Half edges the storage has room for.
+};
 
-class Mesh : public Entity {
+/**
+ *
+ * Delaunay triangulation of points with Real (float, double or int32_t) coordinates.
+ * Use Mesh (double), FloatMesh or IntMesh. The predicates are exact either way; float
+ * halves the memory the points take, but inputs are rounded to float first.
+ * IntMesh is for pixel and grid inputs: its predicates are plain integer arithmetic,
+ * with no filter and no fallback. Inputs are truncated to int and have to be within
+ * Predicates::INT_COORD_MAX, which debug builds assert (see InRange).
+ * The storage of a mesh, scratch space included, comes from the MemoryResource given
+ * to its constructor, so that many small meshes can live in one Arena. Only the
+ * temporary work space of GenerateDivideAndConquer stays on the heap.
+ *
+ */
+template<class Real>
+class BasicMesh : public Entity {
+    template<class> friend class DivideAndConquer;
 public:
-    Mesh();
+    typedef Vec2<Real> Point;
+    typedef MeshStats Stats;
+    typedef vector<Point, ResourceAllocator<Point> > PointVector;
+    typedef vector<HalfEdge, ResourceAllocator<HalfEdge> > EdgeVector;
+    typedef vector<int, ResourceAllocator<int> > IndexVector;
+    typedef std::unordered_multimap<int, int, hash<int>, equal_to<int>,
+            ResourceAllocator<pair<const int, int> > > DuplicateMap;
+
+    /**
+     * GetType() of every mesh of this instantiation: MESH, FLOAT_MESH or INT_MESH.
+     */
+    static const EntityType ENTITY_TYPE;
+
+    /**
+     * @param resource Where the storage comes from, NULL for the heap. Must outlive the mesh.
+     */
+    explicit BasicMesh(MemoryResource *resource = NULL);
+
     /**
      *
-     * Receives a verts in the ZX plane and returns a delaunay triangulation.
-     * @param verts
-     * @return
+     * Triangulates points[0, count) into mesh, replacing what it held but keeping its
+     * storage. The points are only read: the mesh takes its own copy, in insertion order.
+     * @param inputIndex If not NULL, receives for every vertex of the mesh the index of
+     *        its point in points.
+     * @param order BRIO keeps consecutive insertions close to each other.
+     */
+    static void Generate(const Vec *points, int count, BasicMesh *mesh, vector<int> *inputIndex = NULL,
+            InsertionOrder order = InsertionOrder::BRIO);
+
+    /**
+     * Same, into a new mesh, which moves out.
+     */
+    static BasicMesh Generate(const vector<Vec> &verts, InsertionOrder order = InsertionOrder::BRIO);
+
+    /**
+     * Same, straight from a mapped point file: the points are copied once, into the mesh.
+     */
+    static BasicMesh Generate(const MappedPoints &points, InsertionOrder order = InsertionOrder::BRIO);
+
+    /**
+     *
+     * Same result as Generate, built by Guibas-Stolfi divide and conquer instead of
+     * incremental insertion. O(n log n) worst case, dominated by the sort.
+     * The vertices of the mesh are sorted by x, then y. Duplicates are left as isolated vertices.
+     * @param numThreads Threads used for the sort and the recursion. 0 uses every core.
+     *        The mesh is the same for any number of threads.
+     */
+    static void GenerateDivideAndConquer(const Vec *points, int count, BasicMesh *mesh,
+            vector<int> *inputIndex = NULL, int numThreads = 0);
+
+    static BasicMesh GenerateDivideAndConquer(const vector<Vec> &verts, int numThreads = 0);
+
+    /**
+     * Generate into this mesh. Its storage and scratch space are reused, so rebuilding
+     * with as many points as it has held before does not allocate.
+     */
+    void Rebuild(const Vec *points, int count, InsertionOrder order = InsertionOrder::BRIO);
+
+    /**
+     * Removes every point and face. The storage is kept for the next points.
      */
-    static const Mesh Generate(vector<Vec> *verts);
-    const vector<HalfEdge> * GetEdges() const;
-    const vector<Vec> * GetVerts() const;
-    const set<int> * GetFaces() const;
+    void Clear();
+
+    /**
+     * Adds a point to the existing triangulation: one locate plus local flips.
+     * Points outside of the convex hull are connected to every hull edge they can see.
+     * @return Index of the point in GetVerts(). If an equal point is already
+     *         in the mesh, its index is returned and nothing is added.
+     */
+    int Insert(const Point &v);
+
+    /**
+     * Same, from a Vec. For IntMesh its range is checked before it is truncated.
+     */
+    int Insert(const Vec &v);
+
+    /**
+     * Adds a batch of points, in the given order.
+     */
+    void Insert(vector<Vec>::const_iterator begin, vector<Vec>::const_iterator end);
+
+    /**
+     * Makes room for numVerts vertices and their faces (Euler bound), so that
+     * inserting up to that many points does not allocate.
+     */
+    void Reserve(int numVerts);
+
+    /**
+     * Can v go into this kind of mesh? Only IntMesh has a limit: |x| and |y| at most
+     * Predicates::INT_COORD_MAX, beyond which its determinants overflow. The Vec is
+     * tested before it is truncated, so check input with this one.
+     */
+    static bool InRange(const Vec &v);
+    static bool InRange(const Point &v);
+
+    /**
+     * Returns the index of the face containing v, or -1 if v is outside of the mesh.
+     */
+    int Locate(const Point &v) const;
+
+    /**
+     * Deletes a vertex and re-triangulates its star, keeping the mesh Delaunay.
+     * Only the faces around the vertex change; O(degree^3) predicates in the worst case,
+     * a few per neighbour in practice. If an isolated duplicate of the vertex is left, it
+     * takes the place of the vertex in its faces instead. The last vertex is moved into
+     * the freed index.
+     * @return The index the moved vertex had before (the old last index).
+     */
+    int Remove(int vertexId);
+
+    const EdgeVector * GetEdges() const;
+    const PointVector * GetVerts() const;
+
+    MemoryResource * GetResource() const { return verts.get_allocator().GetResource(); }
+
+    /**
+     * The edge the next walk starts from, in the face changed or found last.
+     */
+    int GetLocateHint() const { return locateHint; }
+
+    /**
+     * Faces are stored implicitly: the half edges of face f are 3f, 3f + 1 and 3f + 2.
+     * Every face in [0, GetNumFaces()) is live, ghost faces included.
+     */
+    int GetNumFaces() const;
+
+    /**
+     * Every hull edge x -> y has a ghost face (y, x, ghost) on its outer side, where the
+     * ghost is a vertex at infinity (HalfEdgeProperties::GHOST). So every edge has a twin
+     * and the ghost faces make a fan around the hull. They have no area; skip them when drawing.
+     */
+    bool IsGhost(int faceIndex) const;
+    static bool IsGhost(const HalfEdge *edges, int faceIndex);
+
+    /**
+     * The vertices of the convex hull, counter-clockwise. O(h).
+     */
+    void GetHull(vector<int> *hull) const;
+
+    /**
+     * Counters since the mesh was made or since the last ResetStats.
+     * Locate steps per insertion are locateSteps / locates.
+     */
+    Stats GetStats() const;
+    void ResetStats();
+
+    /**
+     * Whether this build counts at all (MESH_STATS).
+     */
+    static bool StatsEnabled();
+
+    /**
+     * The point location walk on bare arrays, so that it also runs on a mapped file
+     * (see MappedMesh). Returns an edge of the face containing v or, if v is outside
+     * of the mesh, of a ghost face whose hull edge has v strictly on its outer side.
+     * @param startEdge Any edge; the walk is short if its face is close to v.
+     * @param stats Counted into, if not NULL.
+     */
+    static int Walk(const HalfEdge *edges, const Point *verts, int startEdge, const Point &v, Stats *stats);
+
+    // Traversal within the implicit triangle layout.
+    static int Next(int edgeIndex) { return edgeIndex % 3 == 2 ? edgeIndex - 2 : edgeIndex + 1; }
+    static int Prev(int edgeIndex) { return edgeIndex % 3 == 0 ? edgeIndex + 2 : edgeIndex - 1; }
+    static int FaceOf(int edgeIndex) { return edgeIndex / 3; }
 
 private:
     // Private functions
@@ -49,16 +240,43 @@ private:
     //================================================================================
 
     /**
-     * Returns a vector of 3 ccw points making a triangle that contain all the vertices in the mesh.
+     * Reorders verts in place for insertion, see Generate.
+     */
+    void Order(InsertionOrder order);
+
+    /**
+     * Throws away all faces and triangulates verts again, in index order.
+     * Vertex indices don't change.
+     */
+    void Triangulate();
+
+    /**
+     * Locates verts[iVec] and adds it to the mesh.
+     * @return iVec, or the index of an equal vertex already in the mesh (nothing is inserted).
+     */
+    int InsertVertex(int iVec);
+
+    /**
+     * Walk from locateHint.
+     */
+    int Walk(const Point &v) const;
+
+    /**
+     * Twice the signed area of the triangle made by edge edgeIndex and v.
+     * Positive when v is to the left of the edge.
+     */
+    double Orientation(int edgeIndex, const Point &v) const;
+
+    /**
+     * The edge of a ghost face that doesn't touch the ghost. Its twin is a hull edge.
      */
-    vector<Vec> GetBoundingTriangle();
-    FRIEND_TEST(MeshTest,BoundingTriangle);
+    int RealEdge(int faceIndex) const;
+    static int RealEdge(const HalfEdge *edges, int faceIndex);
 
     /**
-     * Returns the index of the face containing the vector
-     * Implementation This is linear-time.
+     * Gives every edge without a twin a ghost face.
      */
-    int GetContainingFace(int iVec);
+    void AddGhostFaces();
 
     /**
      * Will insert vec into triangle f and mutate it into 3 triangles.
@@ -74,29 +292,106 @@ private:
      */
     void SwapEdge(int edgeIndex);
 
+    /**
+     * Rotates an edge within its (convex) bounding quadrilateral, unconditionally.
+     */
+    void Flip(int edgeIndex);
+
     /**
      * Removes face and relevant edges. Cleans up to leave everything sanitized.
+     * The last face is moved into the hole to keep the face range dense.
      * @param face
      */
     void RemoveFace(int face);
+
+    /**
+     * Returns an edge ending at the same point as edgeIndex but in another face, or -1.
+     */
+    int OtherIncident(int edgeIndex) const;
+
+    /**
+     * All edges ending at vertex, in order around it (clockwise). The ghost is a
+     * neighbour of every hull vertex, so the star is always closed.
+     */
+    void VertexEdges(int vertex, IndexVector *star) const;
+
+    /**
+     * Takes an isolated vertex out of verts by moving the last one into its place.
+     * @return The old index of the moved vertex.
+     */
+    int RemoveIndex(int vertexId);
+
+    /**
+     * Bookkeeping of duplicates, see duplicates. AddDuplicate makes the isolated vertex
+     * dup a duplicate of vertex, ForgetDuplicate undoes it and MoveDuplicates gives the
+     * duplicates of from to another vertex at the same point.
+     */
+    void AddDuplicate(int vertex, int dup);
+    void ForgetDuplicate(int dup);
+    void MoveDuplicates(int from, int to);
+
+    /**
+     * Is (link[a], link[b], link[c]) a face of the triangulation of the link without
+     * the vertex, see Remove? The ghost is never part of an ear.
+     */
+    bool IsDelaunayEar(const IndexVector &link, int a, int b, int c) const;
+
+    /**
+     * Writes the points of face f. Twins are left untouched.
+     */
+    void SetFace(int face, int p0, int p1, int p2);
+
+    /**
+     * Makes e1 and e2 twins. e2 can be NO_TWIN.
+     */
+    void Link(int e1, int e2);
     /**
      *
      * @param v
      * @param t
      * @return Is v inside t?
      */
-    bool IsInsideTriangle(Vec *v, Face t);
+    bool IsInsideTriangle(const Point &v, Face t);
+
+    /**
+     * Would vecIndex (possibly the ghost) make face faceIndex illegal?
+     */
+    bool IsInsideCircumcircle(int vecIndex, int faceIndex) const;
 
-    bool IsInsideCircumcircle(Vec *v, Face t);
-    int FindFace(int edgeIndex);
+    int Incident(int vertex) const {
+        return vertex == (int) HalfEdgeProperties::GHOST ? ghostIncident : incident[vertex];
+    }
+    void SetIncident(int vertex, int edgeIndex) {
+        if (vertex == (int) HalfEdgeProperties::GHOST) {
+            ghostIncident = edgeIndex;
+        } else {
+            incident[vertex] = edgeIndex;
+        }
+    }
 
     //================================================================================
     // Private members
     //================================================================================
 
-    vector<Vec>                 verts;
-    vector<HalfEdge>            edges;
-    set<int>                    faces; //indices into edges
+    PointVector                 verts; // x and y only, see Vec2.
+    EdgeVector                  edges; // Three per face, see GetNumFaces.
+    IndexVector                 incident; // An edge ending at each vertex, -1 if none,
+                                          // -2 - v for a duplicate of vertex v.
+    int                         locateHint; // Edge of the last split face. Start of the next walk.
+    int                         ghostIncident; // An edge ending at the ghost, -1 without faces.
+    DuplicateMap                duplicates; // Vertex in the faces -> its isolated duplicates.
+
+    // Scratch space, kept between calls so that insertion does not allocate.
+    IndexVector                 flipStack; // SwapEdge.
+    IndexVector                 starScratch; // RemoveIndex.
+    IndexVector                 orderScratch; // Insertion order of Generate.
+    SpatialSort::Scratch        sortScratch; // BRIO keys.
+
+    mutable Stats               stats; // Also counted by the const queries.
 };
 
+typedef BasicMesh<double> Mesh;
+typedef BasicMesh<float> FloatMesh;
+typedef BasicMesh<int32_t> IntMesh;
+
 #endif /* MESH_H_ */
@@ -0,0 +1,268 @@
+/*
+ * Predicates.cc
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Predicates.h"
+
+/*
+ * Expansion arithmetic. An expansion is a sum of doubles that don't overlap, stored
+ * in increasing order of magnitude; its sign is the sign of the last component.
+ * Every function returns the number of components written, zeros are dropped.
+ */
+
+// Dekker's split: a = hi + lo, each with at most 26 significant bits.
+inline void Split(double a, double *hi, double *lo) {
+    const double c = 134217729.0 * a; // 2^27 + 1
+    const double big = c - a;
+    *hi = c - big;
+    *lo = a - *hi;
+}
+
+// x + y = a + b exactly, with x = fl(a + b).
+inline void TwoSum(double a, double b, double *x, double *y) {
+    *x = a + b;
+    const double bVirt = *x - a;
+    const double aVirt = *x - bVirt;
+    *y = (a - aVirt) + (b - bVirt);
+}
+
+// Same as TwoSum, requires |a| >= |b|.
+inline void FastTwoSum(double a, double b, double *x, double *y) {
+    *x = a + b;
+    *y = b - (*x - a);
+}
+
+// x + y = a * b exactly, with x = fl(a * b). b is already split.
+inline void TwoProductPresplit(double a, double b, double bHi, double bLo, double *x, double *y) {
+    *x = a * b;
+    double aHi, aLo;
+    Split(a, &aHi, &aLo);
+    const double err1 = *x - aHi * bHi;
+    const double err2 = err1 - aLo * bHi;
+    const double err3 = err2 - aHi * bLo;
+    *y = aLo * bLo - err3;
+}
+
+inline void TwoProduct(double a, double b, double *x, double *y) {
+    double bHi, bLo;
+    Split(b, &bHi, &bLo);
+    TwoProductPresplit(a, b, bHi, bLo, x, y);
+}
+
+// h = e + f. h needs room for eLen + fLen components.
+inline int ExpansionSum(int eLen, const double *e, int fLen, const double *f, double *h) {
+    int ei = 0, fi = 0, hi = 0;
+    double eNow = e[0], fNow = f[0];
+    double q, qNew, hh;
+    if ((fNow > eNow) == (fNow > -eNow)) {
+        q = eNow;
+        eNow = ++ei < eLen ? e[ei] : 0;
+    } else {
+        q = fNow;
+        fNow = ++fi < fLen ? f[fi] : 0;
+    }
+    if (ei < eLen && fi < fLen) {
+        if ((fNow > eNow) == (fNow > -eNow)) {
+            FastTwoSum(eNow, q, &qNew, &hh);
+            eNow = ++ei < eLen ? e[ei] : 0;
+        } else {
+            FastTwoSum(fNow, q, &qNew, &hh);
+            fNow = ++fi < fLen ? f[fi] : 0;
+        }
+        q = qNew;
+        if (hh != 0) {
+            h[hi++] = hh;
+        }
+        while (ei < eLen && fi < fLen) {
+            if ((fNow > eNow) == (fNow > -eNow)) {
+                TwoSum(q, eNow, &qNew, &hh);
+                eNow = ++ei < eLen ? e[ei] : 0;
+            } else {
+                TwoSum(q, fNow, &qNew, &hh);
+                fNow = ++fi < fLen ? f[fi] : 0;
+            }
+            q = qNew;
+            if (hh != 0) {
+                h[hi++] = hh;
+            }
+        }
+    }
+    while (ei < eLen) {
+        TwoSum(q, eNow, &qNew, &hh);
+        eNow = ++ei < eLen ? e[ei] : 0;
+        q = qNew;
+        if (hh != 0) {
+            h[hi++] = hh;
+        }
+    }
+    while (fi < fLen) {
+        TwoSum(q, fNow, &qNew, &hh);
+        fNow = ++fi < fLen ? f[fi] : 0;
+        q = qNew;
+        if (hh != 0) {
+            h[hi++] = hh;
+        }
+    }
+    if (q != 0 || hi == 0) {
+        h[hi++] = q;
+    }
+    return hi;
+}
+
+// h = b * e. h needs room for 2 * eLen components.
+inline int ScaleExpansion(int eLen, const double *e, double b, double *h) {
+    double bHi, bLo;
+    Split(b, &bHi, &bLo);
+    double q, hh;
+    TwoProductPresplit(e[0], b, bHi, bLo, &q, &hh);
+    int hi = 0;
+    if (hh != 0) {
+        h[hi++] = hh;
+    }
+    for (int ei = 1; ei < eLen; ++ei) {
+        double product1, product0, sum;
+        TwoProductPresplit(e[ei], b, bHi, bLo, &product1, &product0);
+        TwoSum(q, product0, &sum, &hh);
+        if (hh != 0) {
+            h[hi++] = hh;
+        }
+        FastTwoSum(product1, sum, &q, &hh);
+        if (hh != 0) {
+            h[hi++] = hh;
+        }
+    }
+    if (q != 0 || hi == 0) {
+        h[hi++] = q;
+    }
+    return hi;
+}
+
+// h = a * b - c * d. h needs room for 4 components.
+inline int TwoTwoDiff(double a, double b, double c, double d, double *h) {
+    double ab[2], cd[2];
+    TwoProduct(a, b, &ab[1], &ab[0]);
+    TwoProduct(-c, d, &cd[1], &cd[0]);
+    return ExpansionSum(2, ab, 2, cd, h);
+}
+
+/*
+ * The determinant of the 3x3 matrix with rows (x, y, 1), from the 2x2 minors of the
+ * raw coordinates, none of which round.
+ */
+/*static*/double Predicates::Orient2dExact(const Vec2d &a, const Vec2d &b, const Vec2d &c) {
+    double ab[4], bc[4], ca[4], abbc[8], det[12];
+    const int abLen = TwoTwoDiff(a.x, b.y, b.x, a.y, ab);
+    const int bcLen = TwoTwoDiff(b.x, c.y, c.x, b.y, bc);
+    const int caLen = TwoTwoDiff(c.x, a.y, a.x, c.y, ca);
+    const int abbcLen = ExpansionSum(abLen, ab, bcLen, bc, abbc);
+    const int detLen = ExpansionSum(abbcLen, abbc, caLen, ca, det);
+    return det[detLen - 1];
+}
+
+/*static*/double Predicates::InCircleSlow(const Vec2d &a, const Vec2d &b, const Vec2d &c, const Vec2d &d) {
+    const double adx = a.x - d.x, ady = a.y - d.y;
+    const double bdx = b.x - d.x, bdy = b.y - d.y;
+    const double cdx = c.x - d.x, cdy = c.y - d.y;
+
+    const double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+    const double cdxady = cdx * ady, adxcdy = adx * cdy;
+    const double adxbdy = adx * bdy, bdxady = bdx * ady;
+    const double aLift = adx * adx + ady * ady;
+    const double bLift = bdx * bdx + bdy * bdy;
+    const double cLift = cdx * cdx + cdy * cdy;
+
+    const double det = aLift * (bdxcdy - cdxbdy)
+            + bLift * (cdxady - adxcdy)
+            + cLift * (adxbdy - bdxady);
+    const double permanent = (fabs(bdxcdy) + fabs(cdxbdy)) * aLift
+            + (fabs(cdxady) + fabs(adxcdy)) * bLift
+            + (fabs(adxbdy) + fabs(bdxady)) * cLift;
+    const double errBound = ICC_ERR_BOUND * permanent;
+    if (det > errBound || -det > errBound) {
+        return det;
+    }
+    return InCircleExact(a, b, c, d);
+}
+
+/*
+ * Laplace expansion of the 4x4 matrix with rows (x, y, x^2 + y^2, 1) along the lifted
+ * column. Each cofactor is an orientation of three of the points, built from the 2x2
+ * minors of the raw coordinates. Buffer sizes are the worst case component counts.
+ */
+/*static*/double Predicates::InCircleExact(const Vec2d &a, const Vec2d &b, const Vec2d &c, const Vec2d &d) {
+    double ab[4], bc[4], cd[4], da[4], ac[4], bd[4];
+    const int abLen = TwoTwoDiff(a.x, b.y, b.x, a.y, ab);
+    const int bcLen = TwoTwoDiff(b.x, c.y, c.x, b.y, bc);
+    const int cdLen = TwoTwoDiff(c.x, d.y, d.x, c.y, cd);
+    const int daLen = TwoTwoDiff(d.x, a.y, a.x, d.y, da);
+    const int acLen = TwoTwoDiff(a.x, c.y, c.x, a.y, ac);
+    const int bdLen = TwoTwoDiff(b.x, d.y, d.x, b.y, bd);
+
+    // Orientations of (c, d, a), (d, a, b), (a, b, c) and (b, c, d).
+    double temp8[8], cda[12], dab[12], abc[12], bcd[12];
+    int tempLen = ExpansionSum(cdLen, cd, daLen, da, temp8);
+    const int cdaLen = ExpansionSum(tempLen, temp8, acLen, ac, cda);
+    tempLen = ExpansionSum(daLen, da, abLen, ab, temp8);
+    const int dabLen = ExpansionSum(tempLen, temp8, bdLen, bd, dab);
+    for (int i = 0; i < bdLen; ++i) {
+        bd[i] = -bd[i];
+    }
+    for (int i = 0; i < acLen; ++i) {
+        ac[i] = -ac[i];
+    }
+    tempLen = ExpansionSum(abLen, ab, bcLen, bc, temp8);
+    const int abcLen = ExpansionSum(tempLen, temp8, acLen, ac, abc);
+    tempLen = ExpansionSum(bcLen, bc, cdLen, cd, temp8);
+    const int bcdLen = ExpansionSum(tempLen, temp8, bdLen, bd, bcd);
+
+    // Cofactor times the lifted coordinate of the fourth point, with alternating signs.
+    double det24x[24], det24y[24], det48x[48], det48y[48];
+    double aDet[96], bDet[96], cDet[96], dDet[96];
+    int xLen, yLen;
+
+    xLen = ScaleExpansion(bcdLen, bcd, a.x, det24x);
+    xLen = ScaleExpansion(xLen, det24x, a.x, det48x);
+    yLen = ScaleExpansion(bcdLen, bcd, a.y, det24y);
+    yLen = ScaleExpansion(yLen, det24y, a.y, det48y);
+    const int aLen = ExpansionSum(xLen, det48x, yLen, det48y, aDet);
+
+    xLen = ScaleExpansion(cdaLen, cda, b.x, det24x);
+    xLen = ScaleExpansion(xLen, det24x, -b.x, det48x);
+    yLen = ScaleExpansion(cdaLen, cda, b.y, det24y);
+    yLen = ScaleExpansion(yLen, det24y, -b.y, det48y);
+    const int bLen = ExpansionSum(xLen, det48x, yLen, det48y, bDet);
+
+    xLen = ScaleExpansion(dabLen, dab, c.x, det24x);
+    xLen = ScaleExpansion(xLen, det24x, c.x, det48x);
+    yLen = ScaleExpansion(dabLen, dab, c.y, det24y);
+    yLen = ScaleExpansion(yLen, det24y, c.y, det48y);
+    const int cLen = ExpansionSum(xLen, det48x, yLen, det48y, cDet);
+
+    xLen = ScaleExpansion(abcLen, abc, d.x, det24x);
+    xLen = ScaleExpansion(xLen, det24x, -d.x, det48x);
+    yLen = ScaleExpansion(abcLen, abc, d.y, det24y);
+    yLen = ScaleExpansion(yLen, det24y, -d.y, det48y);
+    const int dLen = ExpansionSum(xLen, det48x, yLen, det48y, dDet);
+
+    double abDet[192], cdDet[192], det[384];
+    const int abDetLen = ExpansionSum(aLen, aDet, bLen, bDet, abDet);
+    const int cdDetLen = ExpansionSum(cLen, cDet, dLen, dDet, cdDet);
+    const int detLen = ExpansionSum(abDetLen, abDet, cdDetLen, cdDet, det);
+    return det[detLen - 1];
+}
@@ -0,0 +1,225 @@
+/*
+ * Predicates.h
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PREDICATES_H_
+#define PREDICATES_H_
+
+#include "common.h"
+
+/**
+ *
+ * Geometric predicates with exact signs, after Shewchuk's "Adaptive Precision
+ * Floating-Point Arithmetic and Fast Robust Geometric Predicates".
+ * The determinant is first evaluated in doubles together with a bound on its rounding
+ * error. Only when the sign is in doubt it is evaluated again with expansion arithmetic,
+ * which is exact (barring overflow and underflow).
+ * Integer points skip all of that: their determinants fit in int64_t / __int128.
+ *
+ */
+class Predicates {
+public:
+    /**
+     * Integer coordinates have to be within [-INT_COORD_MAX, INT_COORD_MAX]. Differences
+     * then fit in 31 bits and the incircle determinant stays below 2^124.
+     */
+    static const int32_t INT_COORD_MAX = 1 << 29;
+
+    /**
+     * Twice the signed area of the triangle abc.
+     * Positive if abc is counter-clockwise, negative if clockwise, zero if collinear.
+     * Only the sign is exact.
+     */
+    static double Orient2d(const Vec2d &a, const Vec2d &b, const Vec2d &c) {
+        const double detLeft = (a.x - c.x) * (b.y - c.y);
+        const double detRight = (a.y - c.y) * (b.x - c.x);
+        const double det = detLeft - detRight;
+        // Shewchuk branches on the signs of the two products. When they differ nothing
+        // cancels, and |detLeft + detRight| <= |det| passes the test below anyway.
+        const double detSum = fabs(detLeft + detRight);
+        const double errBound = CCW_ERR_BOUND * detSum;
+        if (det >= errBound || -det >= errBound) {
+            return det;
+        }
+        return Orient2dExact(a, b, c);
+    }
+
+    /**
+     * Positive if d is inside the circle through the counter-clockwise triangle abc,
+     * negative if outside, zero if the four points are cocircular.
+     * Only the sign is exact.
+     */
+    static double InCircle(const Vec2d &a, const Vec2d &b, const Vec2d &c, const Vec2d &d) {
+        const double det = InCircleFilter(a, b, c, d);
+        if (det != 0) {
+            return det;
+        }
+        return InCircleSlow(a, b, c, d);
+    }
+
+    /**
+     * The first, cheapest stage of InCircle: the determinant in doubles if that settles
+     * its sign, else 0. Small enough to inline into a hot loop, which then calls
+     * InCircle on a 0. It nearly never gives up on points in general position.
+     */
+    static double InCircleFilter(const Vec2d &a, const Vec2d &b, const Vec2d &c, const Vec2d &d) {
+        const double adx = a.x - d.x, ady = a.y - d.y;
+        const double bdx = b.x - d.x, bdy = b.y - d.y;
+        const double cdx = c.x - d.x, cdy = c.y - d.y;
+        const double aLift = adx * adx + ady * ady;
+        const double bLift = bdx * bdx + bdy * bdy;
+        const double cLift = cdx * cdx + cdy * cdy;
+        const double det = aLift * (bdx * cdy - cdx * bdy)
+                + bLift * (cdx * ady - adx * cdy)
+                + cLift * (adx * bdy - bdx * ady);
+        // |bdx * cdy| + |cdx * bdy| <= (bLift + cLift) / 2 and so on, so the permanent of
+        // the error bound is at most the sum of the pairwise products of the lifts.
+        const double errBound = ICC_LIFT_ERR_BOUND * (aLift * bLift + bLift * cLift + cLift * aLift);
+        if (det > errBound || -det > errBound) {
+            return det;
+        }
+        return 0;
+    }
+
+    /**
+     * Vec converts to any Vec2; it means double.
+     */
+    static double Orient2d(const Vec &a, const Vec &b, const Vec &c) {
+        return Orient2d(Vec2d(a), Vec2d(b), Vec2d(c));
+    }
+    static double InCircle(const Vec &a, const Vec &b, const Vec &c, const Vec &d) {
+        return InCircle(Vec2d(a), Vec2d(b), Vec2d(c), Vec2d(d));
+    }
+
+    /**
+     * Float points are exact in double, so the same predicates are exact for them.
+     */
+    template<class Real>
+    static double Orient2d(const Vec2<Real> &a, const Vec2<Real> &b, const Vec2<Real> &c) {
+        return Orient2d(Vec2d(a), Vec2d(b), Vec2d(c));
+    }
+    template<class Real>
+    static double InCircle(const Vec2<Real> &a, const Vec2<Real> &b, const Vec2<Real> &c, const Vec2<Real> &d) {
+        return InCircle(Vec2d(a), Vec2d(b), Vec2d(c), Vec2d(d));
+    }
+    template<class Real>
+    static double InCircleFilter(const Vec2<Real> &a, const Vec2<Real> &b, const Vec2<Real> &c,
+            const Vec2<Real> &d) {
+        return InCircleFilter(Vec2d(a), Vec2d(b), Vec2d(c), Vec2d(d));
+    }
+
+    /**
+     * Exact in integers, no filter. The result converts to a double of the same sign.
+     */
+    static double Orient2d(const Vec2i &a, const Vec2i &b, const Vec2i &c) {
+        const int64_t acx = (int64_t) a.x - c.x, acy = (int64_t) a.y - c.y;
+        const int64_t bcx = (int64_t) b.x - c.x, bcy = (int64_t) b.y - c.y;
+        return (double) (acx * bcy - acy * bcx);
+    }
+
+    static double InCircle(const Vec2i &a, const Vec2i &b, const Vec2i &c, const Vec2i &d) {
+        const int64_t adx = (int64_t) a.x - d.x, ady = (int64_t) a.y - d.y;
+        const int64_t bdx = (int64_t) b.x - d.x, bdy = (int64_t) b.y - d.y;
+        const int64_t cdx = (int64_t) c.x - d.x, cdy = (int64_t) c.y - d.y;
+        // Lifts and 2x2 minors are below 2^61; only their products need 128 bits.
+        const __int128 aLift = adx * adx + ady * ady;
+        const __int128 bLift = bdx * bdx + bdy * bdy;
+        const __int128 cLift = cdx * cdx + cdy * cdy;
+        const __int128 det = aLift * (bdx * cdy - cdx * bdy)
+                + bLift * (cdx * ady - adx * cdy)
+                + cLift * (adx * bdy - bdx * ady);
+        return (double) det;
+    }
+
+    /**
+     * Exact already: only an exactly cocircular d gives 0.
+     */
+    static double InCircleFilter(const Vec2i &a, const Vec2i &b, const Vec2i &c, const Vec2i &d) {
+        return InCircle(a, b, c, d);
+    }
+
+    /**
+     * InCircle, with cocircular points resolved by symbolic perturbation: every point is
+     * lifted by an infinitesimal that grows with its rank in x, then y order (Devillers and
+     * Teillaud, "Perturbations for Delaunay and weighted Delaunay 3D triangulations").
+     * The answer depends on the points only, not on where they are stored, so the
+     * triangulation of cocircular points is unique and the same for every insertion order.
+     * Never 0 if abc is counter-clockwise and the points are distinct. P is any Vec2.
+     */
+    template<class P>
+    static double InCirclePerturbed(const P &a, const P &b, const P &c, const P &d) {
+        const double det = InCircle(a, b, c, d);
+        if (det != 0) {
+            return det;
+        }
+        return InCircleTie(a, b, c, d);
+    }
+
+private:
+    template<class P>
+    static bool LessXY(const P *p, const P *q) {
+        return p->x < q->x || (p->x == q->x && p->y < q->y);
+    }
+
+    /**
+     * Sign of the perturbed determinant of cocircular points. Its terms are ordered by
+     * the rank of the perturbation, so the first point from the top of the order that
+     * gives a nonzero coefficient decides: that coefficient is an orientation.
+     */
+    template<class P>
+    static double InCircleTie(const P &a, const P &b, const P &c, const P &d) {
+        if (Orient2d(a, b, c) <= 0) {
+            return 0; // A flat face has no circle, see Mesh::IsInsideCircumcircle.
+        }
+        const P *points[4] = { &a, &b, &c, &d };
+        sort(points, points + 4, LessXY<P>);
+        for (int i = 3; i > 0; --i) {
+            double o = 0;
+            if (points[i] == &d) {
+                return -1;
+            } else if (points[i] == &c) {
+                o = Orient2d(a, b, d);
+            } else if (points[i] == &b) {
+                o = Orient2d(a, d, c);
+            } else {
+                o = Orient2d(d, b, c);
+            }
+            if (o != 0) {
+                return o;
+            }
+        }
+        return -1;
+    }
+
+    // Error bounds of the double evaluations, relative to the permanent.
+    static constexpr double EPSILON = 1.1102230246251565e-16; // 2^-53
+    static constexpr double CCW_ERR_BOUND = (3.0 + 16.0 * EPSILON) * EPSILON;
+    static constexpr double ICC_ERR_BOUND = (10.0 + 96.0 * EPSILON) * EPSILON;
+    // For the lift bound of InCircleFilter, one more unit for the rounding of the bound itself.
+    static constexpr double ICC_LIFT_ERR_BOUND = (11.0 + 96.0 * EPSILON) * EPSILON;
+
+    static double Orient2dExact(const Vec2d &a, const Vec2d &b, const Vec2d &c);
+    /**
+     * InCircle once the filter gave up: the usual bound on the permanent, then exact.
+     */
+    static double InCircleSlow(const Vec2d &a, const Vec2d &b, const Vec2d &c, const Vec2d &d);
+    static double InCircleExact(const Vec2d &a, const Vec2d &b, const Vec2d &c, const Vec2d &d);
+};
+
+#endif /* PREDICATES_H_ */
@@ -20,6 +20,8 @@
 
 #include "Renderer.h"
 #include "Mesh.h"
+#include "MappedMesh.h"
+#include <GL/gl.h>
 
 Renderer renderer;
 
@@ -38,35 +40,50 @@ void Renderer::Push(const Entity * entity) {
 void Renderer::Render() const {
     for(const Entity *e : entities) {
         if(e->GetType() == EntityType::MESH) {
-            auto *faces = ((Mesh *) e)->GetFaces();
-            const vector<HalfEdge> * edges = ((Mesh *) e)->GetEdges();
-            const vector<Vec> * verts = ((Mesh *) e)->GetVerts();
-            glColor3d(0,0,0);
-            glBegin(GL_TRIANGLES);
-            //for(int i = 0; i < faces->size(); ++i) {
-            for(const int fi : *faces) {
-                //const HalfEdge *e1 = &(edges->at(*(faces->find(i))));
-                const HalfEdge *e1 = &(edges->at(fi));
-                const HalfEdge *e2 = &(edges->at(e1->next));
-                const HalfEdge *e3 = &(edges->at(e2->next));
+            const Mesh *mesh = (const Mesh *) e;
+            DrawMesh(mesh->GetVerts()->data(), mesh->GetVerts()->size(), mesh->GetEdges()->data(),
+                    mesh->GetNumFaces());
+        } else if(e->GetType() == EntityType::FLOAT_MESH) {
+            const FloatMesh *mesh = (const FloatMesh *) e;
+            DrawMesh(mesh->GetVerts()->data(), mesh->GetVerts()->size(), mesh->GetEdges()->data(),
+                    mesh->GetNumFaces());
+        } else if(e->GetType() == EntityType::INT_MESH) {
+            const IntMesh *mesh = (const IntMesh *) e;
+            DrawMesh(mesh->GetVerts()->data(), mesh->GetVerts()->size(), mesh->GetEdges()->data(),
+                    mesh->GetNumFaces());
+        } else if(e->GetType() == EntityType::MAPPED_MESH) {
+            const MappedMesh *mesh = (const MappedMesh *) e;
+            DrawMesh(mesh->GetVerts(), mesh->GetNumVerts(), mesh->GetEdges(), mesh->GetNumFaces());
+        }
+    }
+}
+
+template<class Real>
+/*static*/void Renderer::DrawMesh(const Vec2<Real> *verts, int numVerts, const HalfEdge *edges, int numFaces) {
+    glColor3d(0,0,0);
+    glBegin(GL_TRIANGLES);
+    for(int fi = 0; fi < numFaces; ++fi) {
+        if (Mesh::IsGhost(edges, fi)) {
+            continue;
+        }
+        const HalfEdge *e1 = &edges[3 * fi];
+        const HalfEdge *e2 = e1 + 1;
+        const HalfEdge *e3 = e1 + 2;
 
-                const Vec *a = &(verts->at(e1->point));
-                const Vec *b = &(verts->at(e2->point));
-                const Vec *c = &(verts->at(e3->point));
+        const Vec2<Real> *a = &verts[e1->point];
+        const Vec2<Real> *b = &verts[e2->point];
+        const Vec2<Real> *c = &verts[e3->point];
 
-                glVertex2d(a->x,a->y);
-                glVertex2d(b->x,b->y);
-                glVertex2d(c->x,c->y);
-            }
-            glEnd();
+        glVertex2d(a->x,a->y);
+        glVertex2d(b->x,b->y);
+        glVertex2d(c->x,c->y);
+    }
+    glEnd();
 
-            glColor3d(1,0,0);
-            glBegin(GL_POINTS);
-            for(Vec const v : *(verts)) {
-                glVertex2d(v.x, v.y);
-            }
-            glEnd();
-        }
+    glColor3d(1,0,0);
+    glBegin(GL_POINTS);
+    for(int vi = 0; vi < numVerts; ++vi) {
+        glVertex2d(verts[vi].x, verts[vi].y);
     }
+    glEnd();
 }
-
@@ -40,6 +40,12 @@ public:
         return entities.size();
     }
 private:
+    /**
+     * Faces as lines (ghosts skipped), then the points.
+     */
+    template<class Real>
+    static void DrawMesh(const Vec2<Real> *verts, int numVerts, const HalfEdge *edges, int numFaces);
+
     set<const Entity*> entities;
 };
 
@@ -0,0 +1,157 @@
+/*
+ * SpatialSort.cc
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SpatialSort.h"
+
+// Rounds smaller than this are not worth splitting any further.
+const int BRIO_MIN_ROUND = 64;
+
+/**
+ * Standard iterative conversion: at each level find the quadrant,
+ * add the number of cells before it and rotate the coordinates into its frame.
+ */
+uint32_t SpatialSort::HilbertKey(uint32_t x, uint32_t y) {
+    const uint32_t n = 1u << HILBERT_BITS;
+    uint32_t d = 0;
+    for (uint32_t s = n / 2; s > 0; s /= 2) {
+        const uint32_t rx = (x & s) > 0;
+        const uint32_t ry = (y & s) > 0;
+        d += s * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant.
+        if (ry == 0) {
+            if (rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            const uint32_t t = x;
+            x = y;
+            y = t;
+        }
+    }
+    return d;
+}
+
+/**
+ * Sorts a range of indices by their keys.
+ */
+template<class Round>
+static void SortByKey(const uint32_t *keys, int *begin, int *end, Round *sorted) {
+    sorted->clear();
+    for (int *it = begin; it != end; ++it) {
+        sorted->push_back(make_pair(keys[*it], *it));
+    }
+    sort(sorted->begin(), sorted->end());
+    for (auto k : *sorted) {
+        *begin++ = k.second;
+    }
+}
+
+template<class Point>
+void SpatialSort::HilbertKeys(const Point *points, int count, uint32_t *keys) {
+    if (count == 0) {
+        return;
+    }
+    Point min, max;
+    Bounds(points, count, &min, &max);
+    const double cells = (double) ((1u << HILBERT_BITS) - 1);
+    // Degenerate boxes (all points on a line) collapse to a single row of cells.
+    const double sx = max.x > min.x ? cells / (max.x - min.x) : 0;
+    const double sy = max.y > min.y ? cells / (max.y - min.y) : 0;
+    for (int i = 0; i < count; ++i) {
+        const uint32_t x = (uint32_t) ((points[i].x - min.x) * sx);
+        const uint32_t y = (uint32_t) ((points[i].y - min.y) * sy);
+        keys[i] = HilbertKey(x, y);
+    }
+}
+
+template<class Point>
+void SpatialSort::BrioOrder(const Point *points, int count, int *order, Scratch *scratch) {
+    for (int i = 0; i < count; ++i) {
+        order[i] = i;
+    }
+    // Keys in one pass over the points, in their order: the rounds below only
+    // touch the keys, which are smaller and don't move.
+    scratch->keys.resize(count);
+    HilbertKeys(points, count, scratch->keys.data());
+    random_shuffle(order, order + count);
+    // The first round is the largest.
+    scratch->round.reserve(count - count / 2);
+
+    // Rounds are [n/2, n), [n/4, n/2), ... and whatever is left at the front.
+    int end = count;
+    bool backwards = false;
+    while (end > 0) {
+        const int begin = end / 2 >= BRIO_MIN_ROUND ? end / 2 : 0;
+        SortByKey(scratch->keys.data(), order + begin, order + end, &scratch->round);
+        if (backwards) {
+            reverse(order + begin, order + end);
+        }
+        backwards = !backwards;
+        end = begin;
+    }
+}
+
+template<class Point>
+void SpatialSort::BrioSort(vector<Point> *verts) {
+    vector<int> order(verts->size());
+    Scratch scratch;
+    BrioOrder(verts->data(), verts->size(), order.data(), &scratch);
+    vector<Point> sorted;
+    sorted.reserve(order.size());
+    for (int i : order) {
+        sorted.push_back((*verts)[i]);
+    }
+    verts->swap(sorted);
+}
+
+template<class Point>
+void SpatialSort::Bounds(const Point *points, int count, Point *min, Point *max) {
+    assert(count > 0);
+    *min = points[0];
+    *max = points[0];
+    for (int i = 0; i < count; ++i) {
+        const Point &v = points[i];
+        if (v.x < min->x)
+            min->x = v.x;
+        if (v.x > max->x)
+            max->x = v.x;
+        if (v.y < min->y)
+            min->y = v.y;
+        if (v.y > max->y)
+            max->y = v.y;
+    }
+}
+
+template void SpatialSort::HilbertKeys<Vec>(const Vec *, int, uint32_t *);
+template void SpatialSort::HilbertKeys<Vec2d>(const Vec2d *, int, uint32_t *);
+template void SpatialSort::HilbertKeys<Vec2f>(const Vec2f *, int, uint32_t *);
+template void SpatialSort::HilbertKeys<Vec2i>(const Vec2i *, int, uint32_t *);
+template void SpatialSort::BrioOrder<Vec>(const Vec *, int, int *, Scratch *);
+template void SpatialSort::BrioOrder<Vec2d>(const Vec2d *, int, int *, Scratch *);
+template void SpatialSort::BrioOrder<Vec2f>(const Vec2f *, int, int *, Scratch *);
+template void SpatialSort::BrioOrder<Vec2i>(const Vec2i *, int, int *, Scratch *);
+template void SpatialSort::BrioSort<Vec>(vector<Vec> *);
+template void SpatialSort::BrioSort<Vec2d>(vector<Vec2d> *);
+template void SpatialSort::BrioSort<Vec2f>(vector<Vec2f> *);
+template void SpatialSort::BrioSort<Vec2i>(vector<Vec2i> *);
+template void SpatialSort::Bounds<Vec>(const Vec *, int, Vec *, Vec *);
+template void SpatialSort::Bounds<Vec2d>(const Vec2d *, int, Vec2d *, Vec2d *);
+template void SpatialSort::Bounds<Vec2f>(const Vec2f *, int, Vec2f *, Vec2f *);
+template void SpatialSort::Bounds<Vec2i>(const Vec2i *, int, Vec2i *, Vec2i *);
@@ -0,0 +1,96 @@
+/*
+ * SpatialSort.h
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SPATIALSORT_H_
+#define SPATIALSORT_H_
+
+#include "common.h"
+#include "Arena.h"
+
+/**
+ * Order in which Mesh::Generate inserts the points.
+ */
+enum class InsertionOrder {
+    RANDOM = 0,     // Plain random_shuffle.
+    BRIO            // Biased randomized insertion order.
+};
+
+/**
+ *
+ * Orderings that keep consecutive points close to each other in the plane.
+ * The point location walk then stays short and the mesh being modified stays in cache.
+ *
+ */
+class SpatialSort {
+public:
+    /**
+     * Buffers of BrioOrder. Kept by the caller, so that ordering points again
+     * does not allocate once they have grown.
+     */
+    struct Scratch {
+        explicit Scratch(MemoryResource *resource = NULL) : keys(resource), round(resource) {}
+
+        vector<uint32_t, ResourceAllocator<uint32_t> > keys;
+        vector<pair<uint32_t, int>, ResourceAllocator<pair<uint32_t, int> > > round;
+    };
+
+    /**
+     * Number of bits per coordinate used by HilbertKey.
+     */
+    static const int HILBERT_BITS = 16;
+
+    /**
+     * Index of the cell (x, y) along a Hilbert curve filling a
+     * 2^HILBERT_BITS x 2^HILBERT_BITS grid.
+     */
+    static uint32_t HilbertKey(uint32_t x, uint32_t y);
+
+    /**
+     * Hilbert keys of points[0, count), with the grid stretched over their bounding box.
+     * @param keys Receives one key per point, keys[0, count).
+     */
+    template<class Point>
+    static void HilbertKeys(const Point *points, int count, uint32_t *keys);
+
+    /**
+     * Biased randomized insertion order (Amenta, Choi, Rote).
+     * Shuffles the points, splits them in rounds of doubling size and sorts every
+     * round along the Hilbert curve. The direction alternates between rounds so that
+     * the end of a round is close to the start of the next one.
+     * The points are not moved: order[0, count) receives their indices in that order.
+     * Point is Vec, Vec2d, Vec2f or Vec2i.
+     */
+    template<class Point>
+    static void BrioOrder(const Point *points, int count, int *order, Scratch *scratch);
+
+    /**
+     * Reorders the points themselves, as BrioOrder.
+     */
+    template<class Point>
+    static void BrioSort(vector<Point> *verts);
+
+    /**
+     * Returns the bounding box of points[0, count), count > 0.
+     */
+    template<class Point>
+    static void Bounds(const Point *points, int count, Point *min, Point *max);
+};
+
+#endif /* SPATIALSORT_H_ */
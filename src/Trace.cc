@@ -0,0 +1,100 @@
+/*
+ * Trace.cc
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Trace.h"
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+struct Event {
+    const char *name;
+    double begin;
+    double end;
+    int thread;
+};
+
+mutex eventsLock;
+atomic<bool> recording(false);
+chrono::steady_clock::time_point origin;
+vector<Event> events;
+vector<thread::id> threads; // Index in here is the tid of the trace.
+
+int ThreadIndex(thread::id id) {
+    for (int i = 0; i < (int) threads.size(); ++i) {
+        if (threads[i] == id) {
+            return i;
+        }
+    }
+    threads.push_back(id);
+    return threads.size() - 1;
+}
+
+}
+
+/*static*/void Trace::Start() {
+    lock_guard<mutex> guard(eventsLock);
+    events.clear();
+    threads.clear();
+    origin = chrono::steady_clock::now();
+    recording = true;
+}
+
+/*static*/void Trace::Stop() {
+    recording = false;
+}
+
+/*static*/bool Trace::IsRecording() {
+    return recording;
+}
+
+/*static*/double Trace::Now() {
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - origin).count();
+}
+
+/*static*/void Trace::Add(const char *name, double beginUs, double endUs) {
+    if (!recording) {
+        return;
+    }
+    lock_guard<mutex> guard(eventsLock);
+    Event e = { name, beginUs, endUs, ThreadIndex(this_thread::get_id()) };
+    events.push_back(e);
+}
+
+/*static*/bool Trace::Write(const string &path) {
+    lock_guard<mutex> guard(eventsLock);
+    ofstream out(path.c_str());
+    if (!out) {
+        return false;
+    }
+    // "X" events are complete spans. Nested phases are drawn under their parent.
+    out.precision(15);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    for (int i = 0; i < (int) events.size(); ++i) {
+        const Event &e = events[i];
+        out << "  {\"name\": \"" << e.name << "\", \"cat\": \"mesh\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+                << e.thread << ", \"ts\": " << e.begin << ", \"dur\": " << e.end - e.begin << "}"
+                << (i + 1 < (int) events.size() ? ",\n" : "\n");
+    }
+    out << "]}\n";
+    return out.good();
+}
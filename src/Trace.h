@@ -0,0 +1,85 @@
+/*
+ * Trace.h
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "common.h"
+#include <chrono>
+
+/**
+ *
+ * Wall clock time of the phases of mesh generation, written out as a Chrome
+ * trace-event file (chrome://tracing, ui.perfetto.dev).
+ * Nothing is recorded until Start is called; a phase then costs two clock reads
+ * and a locked push_back, so phases are coarse: a whole sort, a whole insertion loop.
+ *
+ */
+class Trace {
+public:
+    /**
+     * Throws away what was recorded before and starts recording.
+     */
+    static void Start();
+
+    static void Stop();
+
+    static bool IsRecording();
+
+    /**
+     * Writes the recorded phases as trace-event JSON. Can be called while recording.
+     * @return false if the file can't be written.
+     */
+    static bool Write(const string &path);
+
+    /**
+     * Records a complete event. Times are microseconds since Start.
+     * Safe to call from any thread.
+     */
+    static void Add(const char *name, double beginUs, double endUs);
+
+    /**
+     * Microseconds since Start.
+     */
+    static double Now();
+};
+
+/**
+ * Records the time from its construction to its destruction as the phase name.
+ * name must outlive the trace, i.e. be a literal.
+ */
+class ScopedPhase {
+public:
+    explicit ScopedPhase(const char *name) : name(name), begin(Trace::IsRecording() ? Trace::Now() : -1) {}
+    ~ScopedPhase() {
+        if (begin >= 0) {
+            Trace::Add(name, begin, Trace::Now());
+        }
+    }
+
+private:
+    ScopedPhase(const ScopedPhase &);
+    ScopedPhase & operator =(const ScopedPhase &);
+
+    const char  *name;
+    double      begin; // -1 if nothing was recording.
+};
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,49 @@
+/*
+ * Vec2.h
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef VEC2_H_
+#define VEC2_H_
+
+#include "Vec.h"
+
+/**
+ * A point of the plane, as the mesh stores it: x and y next to each other,
+ * 16 bytes in double (8 in float or int32_t), so that one load brings a whole point.
+ * Vec converts to it, dropping z.
+ */
+template<class Real>
+class Vec2 {
+public:
+    Vec2() : x(0), y(0) {}
+    Vec2(Real x, Real y) : x(x), y(y) {}
+    Vec2(const Vec &v) : x(v.x), y(v.y) {}
+    // Explicit: double to float loses precision.
+    template<class Other>
+    explicit Vec2(const Vec2<Other> &v) : x(v.x), y(v.y) {}
+
+    Real x;
+    Real y;
+};
+
+typedef Vec2<double> Vec2d;
+typedef Vec2<float> Vec2f;
+typedef Vec2<int32_t> Vec2i;
+
+#endif /* VEC2_H_ */
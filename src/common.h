@@ -24,16 +24,10 @@
 #include <iostream>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <tr1/memory>
 
-#ifndef OPTIMIZE_SET
 #include <set>
-#endif
-#ifdef OPTIMIZE_SET
-//#include <tr1/unordered_set.h> would be preferable, not working for me with clang.
-#include <backward/hash_set>
-#define set __gnu_cxx::hash_set
-#endif
 
 #include <vector>
 #include <algorithm>
@@ -42,14 +36,7 @@
 // Unix
 #include <unistd.h>
 
-// OpenGL / GLUT in linux
-#ifdef __linux__
-#include <QApplication>
-#include <QDesktopWidget>
-#include <qt4/QtGui/QDesktopWidget>
-#include <QtGui>
-#include <QtOpenGL>
-#endif
+// Qt and OpenGL are only used by the window, see Interface/Qt.h.
 
 using namespace std;
 using namespace tr1;
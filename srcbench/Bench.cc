@@ -0,0 +1,412 @@
+/*
+ * Bench.cc
+ *
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Arena.h>
+#include <Mesh.h>
+#include <Trace.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <thread>
+#include <cstring>
+
+/*
+ * Throughput of mesh generation and editing over several point distributions.
+ * Usage: Bench [--max N] [--json FILE] [--dist NAME] [--trace FILE] [--kernel double|float|int]
+ *        [--memory heap|hugepages]
+ * Sizes go from 10^3 up to --max (10^6 by default, 10^7 for the full run) in powers of 10.
+ * Results are printed as a table and written as JSON (bench.json by default).
+ * --trace also records the phases of every generation as a Chrome trace.
+ * --kernel picks the mesh coordinates. For int, the points are first scaled to about 2^20.
+ * --memory hugepages puts the arrays of the generated meshes on 2MB pages (HugePageResource).
+ */
+
+namespace {
+
+/**
+ * Heap allocations, counted to show that insertion doesn't allocate once reserved.
+ * The sort and divide and conquer allocate from several threads.
+ */
+atomic<long> numAllocations(0);
+
+/**
+ * Where the meshes of the generate phases get their storage from, see --memory.
+ */
+MemoryResource *meshMemory = NULL;
+
+/**
+ * Point sets. All of them live in about the unit square.
+ */
+void Uniform(int n, mt19937 *rng, vector<Vec> *out) {
+    uniform_real_distribution<double> u(0, 1);
+    for (int i = 0; i < n; ++i) {
+        out->push_back(Vec(u(*rng), u(*rng)));
+    }
+}
+
+void Gaussian(int n, mt19937 *rng, vector<Vec> *out) {
+    // A few tight clusters: most of the points are close to many others.
+    const int numClusters = 16;
+    uniform_real_distribution<double> u(0, 1);
+    vector<Vec> centers;
+    for (int i = 0; i < numClusters; ++i) {
+        centers.push_back(Vec(u(*rng), u(*rng)));
+    }
+    normal_distribution<double> g(0, 0.02);
+    for (int i = 0; i < n; ++i) {
+        const Vec &c = centers[i % numClusters];
+        out->push_back(Vec(c.x + g(*rng), c.y + g(*rng)));
+    }
+}
+
+void Grid(int n, mt19937 *rng, vector<Vec> *out) {
+    // Every four neighbours are cocircular.
+    const int side = max(2, (int) sqrt((double) n));
+    for (int i = 0; i < n; ++i) {
+        out->push_back(Vec(i % side, i / side));
+    }
+    shuffle(out->begin(), out->end(), *rng);
+}
+
+void Circle(int n, mt19937 *rng, vector<Vec> *out) {
+    // All points on the hull, every incircle test is nearly degenerate.
+    uniform_real_distribution<double> u(0, 2 * M_PI);
+    for (int i = 0; i < n; ++i) {
+        const double a = u(*rng);
+        out->push_back(Vec(cos(a), sin(a)));
+    }
+}
+
+void Sorted(int n, mt19937 *rng, vector<Vec> *out) {
+    // Worst case for walking: every point lands next to the previous one, on the hull.
+    Uniform(n, rng, out);
+    sort(out->begin(), out->end(), [](const Vec &a, const Vec &b) { return a.x < b.x; });
+}
+
+struct Distribution {
+    const char *name;
+    void (*generate)(int, mt19937 *, vector<Vec> *);
+};
+
+const Distribution DISTRIBUTIONS[] = {
+    { "uniform", Uniform },
+    { "gaussian", Gaussian },
+    { "grid", Grid },
+    { "circle", Circle },
+    { "sorted", Sorted }
+};
+
+/**
+ * One timed phase.
+ */
+struct Result {
+    string distribution;
+    string phase;
+    int n;          // Points in the input.
+    int count;      // Operations timed (points generated, queries, inserts...).
+    double seconds;
+    long allocations;
+    MeshStats stats; // All 0 unless the library counts (MESH_STATS).
+
+    Result(const string &distribution, int n)
+            : distribution(distribution), n(n), count(n), seconds(0), allocations(0), stats() {
+    }
+};
+
+/**
+ * Editing phases run on a sample of this many operations at most.
+ */
+const int MAX_SAMPLE = 10000;
+
+/**
+ * The tile phases cut the input in meshes of this many points, each made and thrown away.
+ */
+const int TILE_POINTS = 1000;
+
+/**
+ * For the integer kernel the points are scaled by a power of two, which keeps grids
+ * regular, so that they reach at most INT_RANGE, and rounded.
+ */
+const double INT_RANGE = 1 << 20;
+
+double IntScale(const vector<Vec> &verts) {
+    double range = 1;
+    for (const Vec &v : verts) {
+        range = max(range, max(fabs(v.x), fabs(v.y)));
+    }
+    int exponent;
+    frexp(INT_RANGE / range, &exponent);
+    return ldexp(1.0, exponent - 1);
+}
+
+void Snap(double scale, vector<Vec> *verts) {
+    for (Vec &v : *verts) {
+        v = Vec(floor(v.x * scale + 0.5), floor(v.y * scale + 0.5));
+    }
+}
+
+double Seconds(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+template<class M>
+void Run(const Distribution &dist, int n, vector<Result> *results) {
+    mt19937 rng(n);
+    const int sample = min(n, MAX_SAMPLE);
+    // The points inserted after generation come from the same set, so that they are
+    // new points of the same kind (on the grid, new grid points).
+    vector<Vec> input;
+    input.reserve(n + sample);
+    dist.generate(n + sample, &rng, &input);
+    const double scale = M::ENTITY_TYPE == EntityType::INT_MESH ? IntScale(input) : 1;
+    if (scale != 1) {
+        Snap(scale, &input);
+    }
+    // Rather than truncate what the kernel can't hold.
+    for (const Vec &v : input) {
+        if (!M::InRange(v)) {
+            cerr << dist.name << ": (" << v.x << ", " << v.y << ") is out of range of the kernel\n";
+            exit(1);
+        }
+    }
+    const vector<Vec> extra(input.begin() + n, input.end());
+    input.resize(n);
+
+    Result r(dist.name, n);
+    long allocs = numAllocations;
+    auto start = chrono::steady_clock::now();
+    M mesh(meshMemory);
+    M::Generate(input.data(), n, &mesh);
+    r.seconds = Seconds(start);
+    r.allocations = numAllocations - allocs;
+    r.phase = "generate";
+    r.stats = mesh.GetStats();
+    results->push_back(r);
+
+    // The same again, into the mesh that is already there: what a frame loop
+    // regenerating its mesh pays once it has warmed up.
+    mesh.ResetStats();
+    allocs = numAllocations;
+    start = chrono::steady_clock::now();
+    mesh.Rebuild(input.data(), n);
+    r.seconds = Seconds(start);
+    r.allocations = numAllocations - allocs;
+    r.phase = "rebuild";
+    r.stats = mesh.GetStats();
+    results->push_back(r);
+
+    allocs = numAllocations;
+    start = chrono::steady_clock::now();
+    M dc(meshMemory);
+    M::GenerateDivideAndConquer(input.data(), n, &dc);
+    r.seconds = Seconds(start);
+    r.allocations = numAllocations - allocs;
+    r.phase = "generate_dc";
+    r.stats = dc.GetStats();
+    results->push_back(r);
+
+    // Many short-lived meshes: each on the heap, then all on one arena that is reset
+    // between them. The first tile warms the arena up.
+    r.stats = MeshStats();
+    allocs = numAllocations;
+    start = chrono::steady_clock::now();
+    for (int begin = 0; begin < n; begin += TILE_POINTS) {
+        M tile;
+        M::Generate(input.data() + begin, min(TILE_POINTS, n - begin), &tile);
+    }
+    r.seconds = Seconds(start);
+    r.allocations = numAllocations - allocs;
+    r.phase = "tiles_heap";
+    results->push_back(r);
+
+    Arena arena;
+    allocs = numAllocations;
+    start = chrono::steady_clock::now();
+    for (int begin = 0; begin < n; begin += TILE_POINTS) {
+        {
+            M tile(&arena);
+            M::Generate(input.data() + begin, min(TILE_POINTS, n - begin), &tile);
+        }
+        arena.Reset();
+    }
+    r.seconds = Seconds(start);
+    r.allocations = numAllocations - allocs;
+    r.phase = "tiles_arena";
+    results->push_back(r);
+
+    // Random queries, all walking from the face of the last insertion.
+    vector<Vec> queries;
+    Uniform(sample, &rng, &queries);
+    if (scale != 1) {
+        Snap(scale, &queries);
+    }
+    int found = 0;
+    mesh.ResetStats();
+    start = chrono::steady_clock::now();
+    for (const Vec &q : queries) {
+        found += mesh.Locate(q) >= 0;
+    }
+    r.seconds = Seconds(start);
+    r.allocations = 0;
+    r.phase = "locate";
+    r.count = sample;
+    r.stats = mesh.GetStats();
+    results->push_back(r);
+
+    // More points of the same kind, one at a time: locate, split and flips.
+    mesh.Reserve(mesh.GetVerts()->size() + sample);
+    mesh.ResetStats();
+    allocs = numAllocations;
+    start = chrono::steady_clock::now();
+    for (const Vec &v : extra) {
+        mesh.Insert(v);
+    }
+    r.seconds = Seconds(start);
+    r.allocations = numAllocations - allocs;
+    r.phase = "insert";
+    r.stats = mesh.GetStats();
+    results->push_back(r);
+}
+
+void WriteJson(const char *path, int maxN, const char *memory, const vector<Result> &results) {
+    ofstream out(path);
+    out << "{\n  \"max\": " << maxN << ",\n  \"threads\": " << thread::hardware_concurrency()
+            << ",\n  \"memory\": \"" << memory << "\",\n  \"results\": [\n";
+    for (int i = 0; i < (int) results.size(); ++i) {
+        const Result &r = results[i];
+        out << "    {\"distribution\": \"" << r.distribution << "\", \"phase\": \"" << r.phase
+                << "\", \"n\": " << r.n << ", \"count\": " << r.count
+                << ", \"seconds\": " << r.seconds
+                << ", \"points_per_sec\": " << r.count / r.seconds
+                << ", \"ns_per_point\": " << 1e9 * r.seconds / r.count
+                << ", \"allocations\": " << r.allocations;
+        if (Mesh::StatsEnabled()) {
+            out << ", \"orientation_tests\": " << r.stats.orientationTests
+                    << ", \"incircle_tests\": " << r.stats.incircleTests
+                    << ", \"flips\": " << r.stats.flips
+                    << ", \"max_flip_stack\": " << r.stats.maxFlipStack
+                    << ", \"locate_steps\": " << r.stats.locateSteps
+                    << ", \"edges_live\": " << r.stats.edgesLive
+                    << ", \"edges_capacity\": " << r.stats.edgesCapacity;
+        }
+        out << "}"
+                << (i + 1 < (int) results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+}
+
+void * operator new(size_t size) {
+    numAllocations++;
+    void *p = malloc(size);
+    if (p == NULL) {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) throw() {
+    free(p);
+}
+
+int main(int argc, char **argv) {
+    int maxN = 1000000;
+    const char *json = "bench.json";
+    const char *only = NULL;
+    const char *trace = NULL;
+    const char *kernel = "double";
+    const char *memory = "heap";
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--max") == 0) {
+            maxN = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--json") == 0) {
+            json = argv[i + 1];
+        } else if (strcmp(argv[i], "--dist") == 0) {
+            only = argv[i + 1];
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            trace = argv[i + 1];
+        } else if (strcmp(argv[i], "--kernel") == 0) {
+            kernel = argv[i + 1];
+        } else if (strcmp(argv[i], "--memory") == 0) {
+            memory = argv[i + 1];
+        } else {
+            cerr << "Usage: " << argv[0] << " [--max N] [--json FILE] [--dist NAME] [--trace FILE]"
+                    << " [--kernel double|float|int] [--memory heap|hugepages]\n";
+            return 1;
+        }
+    }
+
+    if (Mesh::StatsEnabled()) {
+        // A debug core (-O0, counters): the times would say nothing about the code.
+        cerr << argv[0] << ": linked against a debug libDelaunayCore, see README\n";
+        return 1;
+    }
+
+    void (*run)(const Distribution &, int, vector<Result> *) = NULL;
+    if (strcmp(kernel, "double") == 0) {
+        run = Run<Mesh>;
+    } else if (strcmp(kernel, "float") == 0) {
+        run = Run<FloatMesh>;
+    } else if (strcmp(kernel, "int") == 0) {
+        run = Run<IntMesh>;
+    } else {
+        cerr << "Unknown kernel " << kernel << "\n";
+        return 1;
+    }
+
+    HugePageResource hugePages;
+    if (strcmp(memory, "hugepages") == 0) {
+        meshMemory = &hugePages;
+    } else if (strcmp(memory, "heap") != 0) {
+        cerr << "Unknown memory " << memory << "\n";
+        return 1;
+    }
+
+    if (trace != NULL) {
+        Trace::Start();
+    }
+    vector<Result> results;
+    printf("%-10s %9s %-12s %9s %10s %14s %10s %8s\n",
+            "dist", "n", "phase", "count", "seconds", "points/sec", "ns/point", "allocs");
+    for (const Distribution &dist : DISTRIBUTIONS) {
+        if (only != NULL && strcmp(only, dist.name) != 0) {
+            continue;
+        }
+        for (int n = 1000; n <= maxN; n *= 10) {
+            const int first = results.size();
+            run(dist, n, &results);
+            for (int i = first; i < (int) results.size(); ++i) {
+                const Result &r = results[i];
+                printf("%-10s %9d %-12s %9d %10.4f %14.0f %10.1f %8ld\n", r.distribution.c_str(), r.n,
+                        r.phase.c_str(), r.count, r.seconds, r.count / r.seconds,
+                        1e9 * r.seconds / r.count, r.allocations);
+            }
+            fflush(stdout);
+        }
+    }
+    WriteJson(json, maxN, memory, results);
+    if (trace != NULL && !Trace::Write(trace)) {
+        cerr << "Can't write " << trace << "\n";
+        return 1;
+    }
+    return 0;
+}
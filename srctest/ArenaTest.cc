@@ -0,0 +1,161 @@
+/*
+ * ArenaTest.cc
+ *
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include <Arena.h>
+#include <cstring>
+
+namespace {
+
+/**
+ * Heap resource that keeps track of what is outstanding.
+ */
+class CountingResource : public MemoryResource {
+public:
+    CountingResource() : live(0), blocks(0) {}
+
+    void * Allocate(size_t bytes, size_t alignment) {
+        live += bytes;
+        blocks++;
+        return MemoryResource::Heap()->Allocate(bytes, alignment);
+    }
+
+    void Deallocate(void *p, size_t bytes, size_t alignment) {
+        live -= bytes;
+        blocks--;
+        MemoryResource::Heap()->Deallocate(p, bytes, alignment);
+    }
+
+    size_t live;
+    int blocks;
+};
+
+/**
+ * Allocations are aligned as asked and don't overlap, whatever their size.
+ */
+TEST(ArenaTest, AlignedAndDisjoint) {
+    Arena arena(256);
+    vector<pair<char *, size_t> > taken;
+    for (int i = 0; i < 1000; ++i) {
+        const size_t bytes = 1 + (i * 37) % 700;
+        const size_t alignment = 1 << (i % 5);
+        char *p = (char *) arena.Allocate(bytes, alignment);
+        ASSERT_EQ(0u, (uintptr_t) p % alignment);
+        memset(p, i, bytes);
+        taken.push_back(make_pair(p, bytes));
+    }
+    sort(taken.begin(), taken.end());
+    for (int i = 1; i < (int) taken.size(); ++i) {
+        ASSERT_LE(taken[i - 1].first + taken[i - 1].second, taken[i].first);
+    }
+}
+
+/**
+ * Blocks grow, so that the number taken from upstream is logarithmic,
+ * and Release gives every one of them back.
+ */
+TEST(ArenaTest, ReleaseFreesEverything) {
+    CountingResource upstream;
+    {
+        Arena arena(1024, &upstream);
+        for (int i = 0; i < 100000; ++i) {
+            arena.Allocate(24, 8);
+        }
+        ASSERT_LE(upstream.blocks, 12);
+        ASSERT_EQ(upstream.live, arena.GetBytesReserved());
+        arena.Release();
+        ASSERT_EQ(0u, upstream.live);
+        ASSERT_EQ(0u, arena.GetBytesReserved());
+        arena.Allocate(10000, 16);
+        ASSERT_EQ(1, upstream.blocks);
+    }
+    // The destructor releases too.
+    ASSERT_EQ(0, upstream.blocks);
+}
+
+/**
+ * Reset merges the blocks into one and carves from its start again.
+ */
+TEST(ArenaTest, ResetKeepsLastBlock) {
+    CountingResource upstream;
+    Arena arena(1024, &upstream);
+    for (int i = 0; i < 1000; ++i) {
+        arena.Allocate(16, 16);
+    }
+    ASSERT_LT(1, upstream.blocks);
+    const size_t reserved = arena.GetBytesReserved();
+    arena.Reset();
+    ASSERT_EQ(1, upstream.blocks);
+    ASSERT_EQ(reserved, upstream.live);
+    ASSERT_EQ(reserved, arena.GetBytesReserved());
+    void *first = arena.Allocate(16, 16);
+    for (int i = 1; i < 1000; ++i) {
+        arena.Allocate(16, 16);
+    }
+    ASSERT_EQ(1, upstream.blocks);
+    arena.Reset();
+    ASSERT_EQ(first, arena.Allocate(16, 16));
+}
+
+/**
+ * Containers allocate from the resource of their allocator, and copies keep it.
+ */
+TEST(ArenaTest, Allocator) {
+    CountingResource upstream;
+    Arena arena(1024, &upstream);
+    vector<int, ResourceAllocator<int> > a(&arena);
+    for (int i = 0; i < 1000; ++i) {
+        a.push_back(i);
+    }
+    ASSERT_LT(0, upstream.blocks);
+    vector<int, ResourceAllocator<int> > b = a;
+    ASSERT_EQ(&arena, b.get_allocator().GetResource());
+    ASSERT_TRUE(a == b);
+    vector<int, ResourceAllocator<int> > heap;
+    ASSERT_EQ(MemoryResource::Heap(), heap.get_allocator().GetResource());
+    ASSERT_TRUE(a.get_allocator() != heap.get_allocator());
+}
+
+/**
+ * Large allocations are regions of whole huge pages, small ones go upstream.
+ */
+TEST(ArenaTest, HugePages) {
+    CountingResource upstream;
+    HugePageResource hugePages(1 << 20, &upstream);
+    const size_t bytes = 3 * HugePageResource::HUGE_PAGE_SIZE + 12345;
+    char *p = (char *) hugePages.Allocate(bytes, 8);
+    ASSERT_EQ(0u, (uintptr_t) p % HugePageResource::HUGE_PAGE_SIZE);
+    memset(p, 1, bytes);
+    ASSERT_EQ(0, upstream.blocks);
+    void *small = hugePages.Allocate(1000, 8);
+    ASSERT_EQ(1, upstream.blocks);
+    hugePages.Deallocate(small, 1000, 8);
+    hugePages.Deallocate(p, bytes, 8);
+    ASSERT_EQ(0, upstream.blocks);
+
+    vector<int, ResourceAllocator<int> > v(&hugePages);
+    for (int i = 0; i < 1000000; ++i) {
+        v.push_back(i);
+    }
+    ASSERT_EQ(0u, (uintptr_t) v.data() % HugePageResource::HUGE_PAGE_SIZE);
+    ASSERT_EQ(999999, v.back());
+}
+
+} // namespace
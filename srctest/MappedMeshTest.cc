@@ -0,0 +1,110 @@
+/*
+ * MappedMeshTest.cc
+ *
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include <MappedMesh.h>
+#include <Mesh.h>
+#include <cstdio>
+
+namespace {
+
+const char *PATH = "mapped_mesh_test.bin";
+
+Mesh RandomMesh(int n) {
+    vector<Vec> verts;
+    for (int i = 0; i < n; ++i) {
+        verts.push_back(Vec(rand() % 10000 / 16.0, rand() % 10000 / 16.0));
+    }
+    return Mesh::Generate(verts);
+}
+
+/**
+ * The mapped mesh has the same arrays as the saved one, and finds the same faces.
+ */
+TEST(MappedMeshTest, SaveAndOpen) {
+    const Mesh mesh = RandomMesh(3000);
+    ASSERT_TRUE(MappedMesh::Save(mesh, PATH));
+    MappedMesh mapped;
+    ASSERT_TRUE(mapped.Open(PATH));
+    ASSERT_EQ((int) mesh.GetVerts()->size(), mapped.GetNumVerts());
+    ASSERT_EQ(mesh.GetNumFaces(), mapped.GetNumFaces());
+    for (int i = 0; i < mapped.GetNumVerts(); ++i) {
+        ASSERT_EQ(mesh.GetVerts()->at(i).x, mapped.GetVerts()[i].x);
+        ASSERT_EQ(mesh.GetVerts()->at(i).y, mapped.GetVerts()[i].y);
+    }
+    for (int i = 0; i < 3 * mapped.GetNumFaces(); ++i) {
+        ASSERT_EQ(mesh.GetEdges()->at(i).point, mapped.GetEdges()[i].point);
+        ASSERT_EQ(mesh.GetEdges()->at(i).twin, mapped.GetEdges()[i].twin);
+    }
+    // Half of the queries from the saved hint, half from the one before.
+    int hint = -1;
+    for (int i = 0; i < 1000; ++i) {
+        const Vec v(rand() % 12000 / 16.0 - 50, rand() % 12000 / 16.0 - 50);
+        const int face = i % 2 == 0 ? mapped.Locate(v) : mapped.Locate(v, &hint);
+        ASSERT_EQ(face == -1, mesh.Locate(v) == -1);
+        if (i % 2 == 1) {
+            ASSERT_TRUE(hint >= 0 && hint < 3 * mapped.GetNumFaces());
+            if (face != -1) {
+                ASSERT_EQ(face, Mesh::FaceOf(hint));
+            }
+        }
+        if (face != -1) {
+            ASSERT_FALSE(mapped.IsGhost(face));
+            const HalfEdge *e = &mapped.GetEdges()[3 * face];
+            for (int j = 0; j < 3; ++j) {
+                const Vec2d &a = mapped.GetVerts()[e[j].point];
+                const Vec2d &b = mapped.GetVerts()[e[(j + 1) % 3].point];
+                ASSERT_GE((b.x - a.x) * (v.y - a.y) - (v.x - a.x) * (b.y - a.y), 0);
+            }
+        }
+    }
+    remove(PATH);
+}
+
+TEST(MappedMeshTest, Empty) {
+    ASSERT_TRUE(MappedMesh::Save(Mesh(), PATH));
+    MappedMesh mapped;
+    ASSERT_TRUE(mapped.Open(PATH));
+    ASSERT_EQ(0, mapped.GetNumFaces());
+    ASSERT_EQ(-1, mapped.Locate(Vec(1, 1)));
+    remove(PATH);
+}
+
+/**
+ * Anything that is not a whole mesh file of this version is refused.
+ */
+TEST(MappedMeshTest, Invalid) {
+    MappedMesh mapped;
+    ASSERT_FALSE(mapped.Open(PATH));
+
+    ASSERT_TRUE(MappedMesh::Save(RandomMesh(100), PATH));
+    ASSERT_EQ(0, truncate(PATH, 1000));
+    ASSERT_FALSE(mapped.Open(PATH));
+
+    ASSERT_TRUE(MappedMesh::Save(RandomMesh(100), PATH));
+    FILE *f = fopen(PATH, "r+b");
+    fputc('X', f);
+    fclose(f);
+    ASSERT_FALSE(mapped.Open(PATH));
+    ASSERT_EQ(0, mapped.GetNumFaces());
+    remove(PATH);
+}
+
+}
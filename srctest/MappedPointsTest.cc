@@ -0,0 +1,105 @@
+/*
+ * MappedPointsTest.cc
+ *
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include <MappedPoints.h>
+#include <Mesh.h>
+#include <cstdio>
+
+namespace {
+
+const char *PATH = "mapped_points_test.bin";
+
+template<class T>
+void WritePoints(const vector<Vec> &verts) {
+    FILE *f = fopen(PATH, "wb");
+    for (const Vec &v : verts) {
+        const T xy[2] = { (T) v.x, (T) v.y };
+        fwrite(xy, sizeof(T), 2, f);
+    }
+    fclose(f);
+}
+
+vector<Vec> RandomPoints(int n) {
+    vector<Vec> verts;
+    for (int i = 0; i < n; ++i) {
+        verts.push_back(Vec(rand() % 10000 / 16.0, rand() % 10000 / 16.0));
+    }
+    return verts;
+}
+
+TEST(MappedPointsTest, Doubles) {
+    const vector<Vec> verts = RandomPoints(3000);
+    WritePoints<double>(verts);
+    MappedPoints points;
+    ASSERT_TRUE(points.Open(PATH, PointFormat::DOUBLE));
+    ASSERT_EQ(3000, points.GetNumPoints());
+    for (int i = 0; i < 3000; ++i) {
+        ASSERT_EQ(verts[i].x, points.Get(i).x);
+        ASSERT_EQ(verts[i].y, points.Get(i).y);
+    }
+    vector<Vec2d> copy;
+    points.AppendTo(&copy);
+    ASSERT_EQ(verts.size(), copy.size());
+    ASSERT_EQ(verts.back().y, copy.back().y);
+    remove(PATH);
+}
+
+TEST(MappedPointsTest, Floats) {
+    const vector<Vec> verts = RandomPoints(100);
+    WritePoints<float>(verts);
+    MappedPoints points;
+    ASSERT_TRUE(points.Open(PATH, PointFormat::FLOAT));
+    ASSERT_EQ(100, points.GetNumPoints());
+    ASSERT_EQ(verts[7].x, points.Get(7).x);
+    // A byte more is not a whole number of points.
+    FILE *f = fopen(PATH, "ab");
+    fputc(0, f);
+    fclose(f);
+    ASSERT_FALSE(points.Open(PATH, PointFormat::FLOAT));
+    ASSERT_EQ(0, points.GetNumPoints());
+    remove(PATH);
+    ASSERT_FALSE(points.Open(PATH, PointFormat::FLOAT));
+}
+
+/**
+ * Generating from the mapping gives the same mesh as from the points in memory.
+ */
+TEST(MappedPointsTest, Generate) {
+    vector<Vec> verts = RandomPoints(2000);
+    WritePoints<double>(verts);
+    MappedPoints points;
+    ASSERT_TRUE(points.Open(PATH, PointFormat::DOUBLE));
+    // The rounds of BRIO are shuffled.
+    srand(1);
+    const Mesh mapped = Mesh::Generate(points);
+    srand(1);
+    const Mesh inMemory = Mesh::Generate(verts);
+    ASSERT_EQ(inMemory.GetVerts()->size(), mapped.GetVerts()->size());
+    ASSERT_EQ(inMemory.GetNumFaces(), mapped.GetNumFaces());
+    // Both are put in the same BRIO order, the mapped one in place.
+    for (int i = 0; i < (int) verts.size(); ++i) {
+        ASSERT_EQ(inMemory.GetVerts()->at(i).x, mapped.GetVerts()->at(i).x);
+        ASSERT_EQ(inMemory.GetVerts()->at(i).y, mapped.GetVerts()->at(i).y);
+    }
+    remove(PATH);
+}
+
+}
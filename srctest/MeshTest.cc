@@ -18,10 +18,13 @@
  *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <Arena.h>
 #include <Mesh.h>
+#include <Predicates.h>
 #include <gtest/gtest.h>
 #include <tr1/random.h>
 #include <random>
+#include <atomic>
 #include <time.h>
 #include <Interface/Linux.h>
 
@@ -59,25 +62,574 @@ protected:
 
 };
 
-extern Vec ToBarycentric2d(Vec*,Vec*,Vec*,Vec*);
+/**
+ * Heap allocations made by the test binary, see InsertDoesNotAllocate. Divide and
+ * conquer allocates from several threads.
+ */
+atomic<long> numAllocations(0);
+
+void * operator new(size_t size) {
+    numAllocations++;
+    void *p = malloc(size);
+    if (p == NULL) {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) throw() {
+    free(p);
+}
+
+/**
+ * Twins have to point back at each other, every real edge has to be locally Delaunay
+ * and the hull (the real edges of the ghost faces) has to be convex.
+ * The real faces have to cover the hull: n points with h hull edges make 2n - 2 - h faces.
+ */
+template<class Real>
+void CheckDelaunay(const BasicMesh<Real> &mesh) {
+    const typename BasicMesh<Real>::EdgeVector &edges = *mesh.GetEdges();
+    const typename BasicMesh<Real>::PointVector &verts = *mesh.GetVerts();
+    const int ghost = (int) HalfEdgeProperties::GHOST;
+    int hull = 0;
+    for (int fi = 0; fi < mesh.GetNumFaces(); ++fi) {
+        if (mesh.IsGhost(fi)) {
+            hull++;
+        }
+        int ei = 3 * fi;
+        do {
+            const HalfEdge &e = edges[ei];
+            ASSERT_NE((int) HalfEdgeProperties::NO_TWIN, e.twin);
+            ASSERT_EQ(ei, edges[e.twin].twin);
+            ASSERT_EQ(e.point, edges[BasicMesh<Real>::Prev(e.twin)].point);
+            const int pa = e.point;
+            const int pb = edges[BasicMesh<Real>::Next(ei)].point;
+            const int pc = edges[BasicMesh<Real>::Prev(ei)].point;
+            const int pd = edges[BasicMesh<Real>::Next(e.twin)].point;
+            if (pa != ghost && pb != ghost && pc != ghost && pd != ghost) {
+                const Vec2d a(verts[pa]), b(verts[pb]), c(verts[pc]), d(verts[pd]);
+                const double adx = a.x - d.x, ady = a.y - d.y;
+                const double bdx = b.x - d.x, bdy = b.y - d.y;
+                const double cdx = c.x - d.x, cdy = c.y - d.y;
+                const double det = (adx * adx + ady * ady) * (bdx * cdy - cdx * bdy)
+                        + (bdx * bdx + bdy * bdy) * (cdx * ady - adx * cdy)
+                        + (cdx * cdx + cdy * cdy) * (adx * bdy - bdx * ady);
+                ASSERT_LE(det, 1e-6) << "Edge " << ei << " is not locally Delaunay";
+            }
+            ei = BasicMesh<Real>::Next(ei);
+        } while (ei != 3 * fi);
+    }
+    ASSERT_EQ(2 * (int) verts.size() - 2 - hull, mesh.GetNumFaces() - hull);
+
+    vector<int> ring;
+    mesh.GetHull(&ring);
+    ASSERT_EQ(hull, (int) ring.size());
+    for (int i = 0; i < (int) ring.size(); ++i) {
+        const Vec2d a(verts[ring[i]]);
+        const Vec2d b(verts[ring[(i + 1) % ring.size()]]);
+        const Vec2d c(verts[ring[(i + 2) % ring.size()]]);
+        ASSERT_GE((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y), 0) << "Hull is not convex";
+    }
+}
+
+/**
+ * The walking point location has to find the right face for every point so that the
+ * resulting mesh is a proper Delaunay triangulation.
+ */
+TEST_F(MeshTest, GenerateIsDelaunay) {
+    vector<Vec> vecs;
+    for(int i = 0; i < 10 * 10 * 10 * 5; ++i){
+        double x =  (double)W * (static_cast<double>(rand()) / RAND_MAX);
+        double y =  (double)H * (static_cast<double>(rand()) / RAND_MAX);
+        vecs.push_back(Vec(x,y));
+    }
+    const Mesh mesh = Mesh::Generate(vecs);
+    ASSERT_EQ(vecs.size(), mesh.GetVerts()->size());
+    CheckDelaunay(mesh);
+}
+
+/**
+ * Divide and conquer has to give a Delaunay triangulation that can be edited incrementally,
+ * also on cocircular grids where every split line is full of collinear points.
+ */
+TEST_F(MeshTest, GenerateDivideAndConquer) {
+    vector<Vec> vecs;
+    for(int i = 0; i < 10 * 10 * 10 * 5; ++i){
+        double x =  (double)W * (static_cast<double>(rand()) / RAND_MAX);
+        double y =  (double)H * (static_cast<double>(rand()) / RAND_MAX);
+        vecs.push_back(Vec(x,y));
+    }
+    Mesh mesh = Mesh::GenerateDivideAndConquer(vecs);
+    ASSERT_EQ(vecs.size(), mesh.GetVerts()->size());
+    CheckDelaunay(mesh);
+    ASSERT_EQ(Mesh::Generate(vecs).GetNumFaces(), mesh.GetNumFaces());
+    for(int i = 0; i < 500; ++i){
+        mesh.Insert(Vec(2 * W * (static_cast<double>(rand()) / RAND_MAX), H / 3));
+    }
+    CheckDelaunay(mesh);
+
+    vector<Vec> grid;
+    for(int i = 0; i < 40; ++i){
+        for(int j = 0; j < 40; ++j){
+            grid.push_back(Vec(i, j));
+        }
+    }
+    CheckDelaunay(Mesh::GenerateDivideAndConquer(grid));
+
+    vector<Vec> line;
+    for(int i = 0; i < 100; ++i){
+        line.push_back(Vec(i, 2 * i));
+    }
+    ASSERT_EQ(0, Mesh::GenerateDivideAndConquer(line).GetNumFaces());
+}
+
+/**
+ * A cocircular grid far from the origin, where the incircle determinant in plain doubles
+ * loses every significant bit.
+ */
+TEST_F(MeshTest, GenerateFarGrid) {
+    vector<Vec> grid;
+    for(int i = 0; i < 30; ++i){
+        for(int j = 0; j < 30; ++j){
+            grid.push_back(Vec(1e8 + i, 1e8 + j));
+        }
+    }
+    CheckDelaunay(Mesh::Generate(grid));
+    CheckDelaunay(Mesh::GenerateDivideAndConquer(grid));
+}
+
+/**
+ * Forking threads must not change the result.
+ */
+TEST_F(MeshTest, GenerateDivideAndConquerThreads) {
+    vector<Vec> vecs;
+    for(int i = 0; i < 40000; ++i){
+        double x =  (double)W * (static_cast<double>(rand()) / RAND_MAX);
+        double y =  (double)H * (static_cast<double>(rand()) / RAND_MAX);
+        vecs.push_back(Vec(x,y));
+    }
+    const Mesh serial = Mesh::GenerateDivideAndConquer(vecs, 1);
+    const Mesh parallel = Mesh::GenerateDivideAndConquer(vecs, 4);
+    CheckDelaunay(parallel);
+    ASSERT_EQ(serial.GetNumFaces(), parallel.GetNumFaces());
+    for(int i = 0; i < 3 * serial.GetNumFaces(); ++i){
+        ASSERT_EQ(serial.GetEdges()->at(i).point, parallel.GetEdges()->at(i).point);
+        ASSERT_EQ(serial.GetEdges()->at(i).twin, parallel.GetEdges()->at(i).twin);
+    }
+}
+
+/**
+ * Points added one at a time keep the mesh Delaunay, and equal points are not added twice.
+ */
+TEST_F(MeshTest, Insert) {
+    for(int i = 0; i < 2000; ++i){
+        double x =  (double)W * (static_cast<double>(rand()) / RAND_MAX);
+        double y =  (double)H * (static_cast<double>(rand()) / RAND_MAX);
+        ASSERT_EQ(i, mesh->Insert(Vec(x,y)));
+    }
+    CheckDelaunay(*mesh);
+    const Vec2d again = mesh->GetVerts()->at(1234);
+    ASSERT_EQ(1234, mesh->Insert(again));
+    ASSERT_EQ(2000, (int) mesh->GetVerts()->size());
+
+    vector<Vec> batch;
+    for(int i = 0; i < 2000; ++i){
+        batch.push_back(Vec(2 * W * (static_cast<double>(rand()) / RAND_MAX), H / 2));
+    }
+    mesh->Insert(batch.begin(), batch.end());
+    ASSERT_EQ(4000, (int) mesh->GetVerts()->size());
+    CheckDelaunay(*mesh);
+}
+
+/**
+ * Once the mesh has reserved room, inserting points (inside and outside of the hull)
+ * must not touch the heap.
+ */
+TEST_F(MeshTest, InsertDoesNotAllocate) {
+    mesh->Reserve(5000);
+    for(int i = 0; i < 1000; ++i){
+        double x =  (double)W * (static_cast<double>(rand()) / RAND_MAX);
+        double y =  (double)H * (static_cast<double>(rand()) / RAND_MAX);
+        mesh->Insert(Vec(x,y));
+    }
+    const long before = numAllocations;
+    for(int i = 0; i < 4000; ++i){
+        double x =  1.5 * W * (static_cast<double>(rand()) / RAND_MAX);
+        double y =  1.5 * H * (static_cast<double>(rand()) / RAND_MAX);
+        mesh->Insert(Vec(x,y));
+    }
+    ASSERT_EQ(before, numAllocations.load());
+    CheckDelaunay(*mesh);
+}
+
+/**
+ * Removing vertices, inside and on the hull, leaves the Delaunay triangulation of the rest.
+ */
+TEST_F(MeshTest, Remove) {
+    vector<Vec> vecs;
+    for(int i = 0; i < 3000; ++i){
+        double x =  (double)W * (static_cast<double>(rand()) / RAND_MAX);
+        double y =  (double)H * (static_cast<double>(rand()) / RAND_MAX);
+        vecs.push_back(Vec(x,y));
+    }
+    Mesh mesh = Mesh::Generate(vecs);
+    for(int i = 0; i < 2000; ++i){
+        const int id = rand() % mesh.GetVerts()->size();
+        const Vec2d last = mesh.GetVerts()->back();
+        const int moved = mesh.Remove(id);
+        ASSERT_EQ((int) mesh.GetVerts()->size(), moved);
+        if (id != moved) {
+            ASSERT_EQ(last.x, mesh.GetVerts()->at(id).x);
+        }
+    }
+    ASSERT_EQ(1000, (int) mesh.GetVerts()->size());
+    CheckDelaunay(mesh);
+}
+
+/**
+ * Grids are full of cocircular and collinear neighbours. Removing from one stays
+ * Delaunay after every step, on the hull too.
+ */
+TEST_F(MeshTest, RemoveFromGrid) {
+    vector<Vec> vecs;
+    for(int x = 0; x < 40; ++x){
+        for(int y = 0; y < 40; ++y){
+            vecs.push_back(Vec(x, y));
+        }
+    }
+    Mesh mesh = Mesh::Generate(vecs);
+    for(int i = 0; i < 300; ++i){
+        mesh.Remove(rand() % mesh.GetVerts()->size());
+        CheckDelaunay(mesh);
+    }
+    ASSERT_EQ(1300, (int) mesh.GetVerts()->size());
+}
+
+/**
+ * Duplicates are kept as isolated vertices. Removing the copy that is in the faces
+ * leaves one of the others in its place, so every point that is left stays in the mesh.
+ */
+TEST_F(MeshTest, RemoveDuplicated) {
+    vector<Vec> vecs;
+    for(int x = 0; x < 12; ++x){
+        for(int y = 0; y < 12; ++y){
+            for(int copies = rand() % 3; copies >= 0; --copies){
+                vecs.push_back(Vec(x, y));
+            }
+        }
+    }
+    for(int method = 0; method < 2; ++method){
+        Mesh mesh = method == 0 ? Mesh::Generate(vecs) : Mesh::GenerateDivideAndConquer(vecs);
+        while (!mesh.GetVerts()->empty()) {
+            mesh.Remove(rand() % mesh.GetVerts()->size());
+            set<pair<double, double> > points;
+            for(const Vec2d &v : *mesh.GetVerts()){
+                points.insert(make_pair(v.x, v.y));
+            }
+            set<int> inFaces;
+            for(const HalfEdge &e : *mesh.GetEdges()){
+                if (e.point != (int) HalfEdgeProperties::GHOST) {
+                    inFaces.insert(e.point);
+                }
+            }
+            if (mesh.GetNumFaces() > 0) {
+                ASSERT_EQ(points.size(), inFaces.size());
+            }
+        }
+    }
+}
+
+/**
+ * Vertices whose neighbours are on a line through them: a degree 4 star with two
+ * neighbours on each side of a line, the middle of a row of points, and the row itself.
+ */
+TEST_F(MeshTest, RemoveCollinearStar) {
+    vector<Vec> star;
+    star.push_back(Vec(0, 0));
+    star.push_back(Vec(-1, 0));
+    star.push_back(Vec(1, 0));
+    star.push_back(Vec(0.2, 2));
+    star.push_back(Vec(-0.3, -3));
+    Mesh mesh = Mesh::Generate(star);
+    for(int i = 0; i < (int) star.size(); ++i){
+        if (mesh.GetVerts()->at(i).x == 0 && mesh.GetVerts()->at(i).y == 0) {
+            mesh.Remove(i);
+            break;
+        }
+    }
+    ASSERT_EQ(4, (int) mesh.GetVerts()->size());
+    CheckDelaunay(mesh);
+
+    vector<Vec> row;
+    for(int x = 0; x < 20; ++x){
+        row.push_back(Vec(x, 0));
+    }
+    row.push_back(Vec(9.5, 1));
+    row.push_back(Vec(9.5, -1));
+    mesh = Mesh::Generate(row);
+    while (mesh.GetVerts()->size() > 3) {
+        // Row points first, from the middle out, then the two off the line.
+        int id = 0;
+        for(int i = 0; i < (int) mesh.GetVerts()->size(); ++i){
+            const Vec2d &v = mesh.GetVerts()->at(i);
+            const Vec2d &best = mesh.GetVerts()->at(id);
+            if (fabs(v.y) < fabs(best.y) || (v.y == best.y && fabs(v.x - 9.5) < fabs(best.x - 9.5))) {
+                id = i;
+            }
+        }
+        mesh.Remove(id);
+        CheckDelaunay(mesh);
+    }
+}
 
 /**
- * A lot of random points in the subset of the plane that we will be using
- * and a check for contention within the generated bounding triangle.
+ * The counters follow the insertions. Without MESH_STATS they all stay at 0.
  */
-TEST_F(MeshTest, BoundingTriangle) {
+TEST_F(MeshTest, Stats) {
     vector<Vec> vecs;
-    Mesh mesh;
-    for(int i = 0; i < 10 * 10 * 10 * 10; ++i){
+    for(int i = 0; i < 2000; ++i){
         double x =  (double)W * (static_cast<double>(rand()) / RAND_MAX);
         double y =  (double)H * (static_cast<double>(rand()) / RAND_MAX);
-        mesh.verts.push_back(Vec(x,y));
+        vecs.push_back(Vec(x,y));
     }
-    vector<Vec> tri = mesh.GetBoundingTriangle();
-    for(auto v : mesh.verts) {
-        Vec bar = ToBarycentric2d(&v, &tri[0], &tri[1], &tri[2]);
-        ASSERT_TRUE(bar.x <= 1 && bar.y <= 1 && bar.z <= 1 && bar.x >= 0 && bar.y >= 0 && bar.z >= 0)
-            << "Barycentric: " << bar << " Vector: " << v <<  endl;
+    Mesh mesh = Mesh::Generate(vecs);
+    Mesh::Stats stats = mesh.GetStats();
+    ASSERT_EQ(3 * mesh.GetNumFaces(), stats.edgesLive);
+    ASSERT_LE(stats.edgesLive, stats.edgesCapacity);
+    if (!Mesh::StatsEnabled()) {
+        ASSERT_EQ(0, stats.flips);
+        ASSERT_EQ(0, stats.locates);
+        return;
     }
+    ASSERT_EQ(2000 - 3, stats.locates);
+    ASSERT_GT(stats.flips, 0);
+    ASSERT_GE(stats.incircleTests, stats.flips);
+    ASSERT_GE(stats.orientationTests, stats.locates);
+    ASSERT_GT(stats.maxFlipStack, 0);
+    // Every insertion adds two faces.
+    ASSERT_EQ(stats.edgesLive, stats.edgesAllocated);
 
+    mesh.ResetStats();
+    mesh.Locate(Vec(W / 2, H / 2));
+    ASSERT_EQ(1, mesh.GetStats().locates);
+    ASSERT_EQ(0, mesh.GetStats().flips);
+}
+
+/**
+ * A float mesh goes through the same code. Points that are apart in double but
+ * round to the same float, or swap order in float, must not break the triangulation.
+ */
+TEST_F(MeshTest, FloatMesh) {
+    vector<Vec> vecs;
+    for(int i = 0; i < 2000; ++i){
+        double x =  (double)W * (static_cast<double>(rand()) / RAND_MAX);
+        double y =  (double)H * (static_cast<double>(rand()) / RAND_MAX);
+        vecs.push_back(Vec(x,y));
+    }
+    const FloatMesh mesh = FloatMesh::Generate(vecs);
+    ASSERT_EQ(EntityType::FLOAT_MESH, mesh.GetType());
+    CheckDelaunay(mesh);
+    const FloatMesh dc = FloatMesh::GenerateDivideAndConquer(vecs);
+    CheckDelaunay(dc);
+    ASSERT_EQ(mesh.GetNumFaces(), dc.GetNumFaces());
+
+    // Same x in float, y in the opposite order in double: D&C has to sort the rounded points.
+    vector<Vec> close;
+    for(int i = 0; i < 100; ++i){
+        close.push_back(Vec(100 + i + 1e-9, 2 * i));
+        close.push_back(Vec(100 + i, 2 * i + 1));
+    }
+    CheckDelaunay(FloatMesh::GenerateDivideAndConquer(close));
+
+    FloatMesh inserted;
+    for(int i = 0; i < 2000; ++i){
+        ASSERT_EQ(i, inserted.Insert(vecs[i]));
+    }
+    CheckDelaunay(inserted);
+}
+
+/**
+ * Pixel and grid inputs through the integer kernel, also at the edge of the allowed
+ * coordinate range, and clicks inserted one at a time on a grid.
+ */
+TEST_F(MeshTest, IntMesh) {
+    const int32_t far = Predicates::INT_COORD_MAX - 64;
+    vector<Vec> grid;
+    for(int i = 0; i < 40; ++i){
+        for(int j = 0; j < 40; ++j){
+            grid.push_back(Vec(far - i, -far + j));
+        }
+    }
+    const IntMesh mesh = IntMesh::Generate(grid);
+    ASSERT_EQ(EntityType::INT_MESH, mesh.GetType());
+    CheckDelaunay(mesh);
+    CheckDelaunay(IntMesh::GenerateDivideAndConquer(grid));
+
+    IntMesh clicks;
+    for(int i = 0; i < 2000; ++i){
+        clicks.Insert(Vec2i(rand() % W / 8 * 8, rand() % H / 8 * 8));
+    }
+    CheckDelaunay(clicks);
+}
+
+/**
+ * Points the integer kernel can't hold are refused, not truncated into a wrong mesh.
+ */
+TEST_F(MeshTest, IntMeshRange) {
+    const double max = Predicates::INT_COORD_MAX;
+    ASSERT_TRUE(IntMesh::InRange(Vec(max, -max)));
+    ASSERT_TRUE(IntMesh::InRange(Vec2i(-Predicates::INT_COORD_MAX, Predicates::INT_COORD_MAX)));
+    ASSERT_FALSE(IntMesh::InRange(Vec(max + 1, 0)));
+    ASSERT_FALSE(IntMesh::InRange(Vec(0, -1e12)));
+    ASSERT_FALSE(IntMesh::InRange(Vec(NAN, 0)));
+    ASSERT_FALSE(IntMesh::InRange(Vec2i(0, Predicates::INT_COORD_MAX + 1)));
+    ASSERT_TRUE(Mesh::InRange(Vec(1e12, 0)));
+#ifndef NDEBUG
+    vector<Vec> far;
+    far.push_back(Vec(0, 0));
+    far.push_back(Vec(1, 0));
+    far.push_back(Vec(0, 4 * max));
+    ASSERT_DEATH(IntMesh::Generate(far), "InRange");
+    ASSERT_DEATH(IntMesh::GenerateDivideAndConquer(far), "InRange");
+    ASSERT_DEATH(IntMesh().Insert(Vec(3e9, 0)), "InRange");
+#endif
+}
+
+/**
+ * Faces as sorted corner triples, in coordinates, so that meshes that store their
+ * points in different orders can be compared.
+ */
+template<class Real>
+set<vector<pair<Real, Real> > > Faces(const BasicMesh<Real> &mesh) {
+    set<vector<pair<Real, Real> > > faces;
+    for (int fi = 0; fi < mesh.GetNumFaces(); ++fi) {
+        if (mesh.IsGhost(fi)) {
+            continue;
+        }
+        vector<pair<Real, Real> > face;
+        for (int ei = 3 * fi; ei < 3 * fi + 3; ++ei) {
+            const Vec2<Real> &v = mesh.GetVerts()->at(mesh.GetEdges()->at(ei).point);
+            face.push_back(make_pair(v.x, v.y));
+        }
+        sort(face.begin(), face.end());
+        faces.insert(face);
+    }
+    return faces;
+}
+
+/**
+ * Cocircular points are broken by symbolic perturbation, so a grid has one
+ * triangulation whatever the insertion order, the same as divide and conquer builds.
+ */
+TEST_F(MeshTest, GridDoesNotDependOnOrder) {
+    vector<Vec> grid;
+    for(int i = 0; i < 30; ++i){
+        for(int j = 0; j < 30; ++j){
+            grid.push_back(Vec(i, j));
+        }
+    }
+    const set<vector<pair<double, double> > > faces = Faces(Mesh::GenerateDivideAndConquer(grid));
+    for(int run = 0; run < 3; ++run){
+        ASSERT_TRUE(faces == Faces(Mesh::Generate(grid, run == 0 ? InsertionOrder::BRIO : InsertionOrder::RANDOM)));
+    }
+
+    Mesh inserted;
+    for(int i = (int) grid.size() - 1; i >= 0; --i){
+        inserted.Insert(grid[i]);
+    }
+    ASSERT_TRUE(faces == Faces(inserted));
+
+    ASSERT_EQ(Faces(IntMesh::GenerateDivideAndConquer(grid)), Faces(IntMesh::Generate(grid)));
+}
+
+/**
+ * The input is only read, and inputIndex maps every vertex back to its point.
+ * A mesh generated into again keeps its storage.
+ */
+TEST_F(MeshTest, GenerateFromSpan) {
+    vector<Vec> vecs;
+    for(int i = 0; i < 2000; ++i){
+        vecs.push_back(Vec(W * (static_cast<double>(rand()) / RAND_MAX), H * (static_cast<double>(rand()) / RAND_MAX)));
+    }
+    const vector<Vec> before = vecs;
+    for(int dc = 0; dc < 2; ++dc){
+        Mesh mesh;
+        vector<int> inputIndex;
+        if (dc) {
+            Mesh::GenerateDivideAndConquer(vecs.data(), vecs.size(), &mesh, &inputIndex);
+        } else {
+            Mesh::Generate(vecs.data(), vecs.size(), &mesh, &inputIndex);
+        }
+        ASSERT_EQ(0, memcmp(before.data(), vecs.data(), vecs.size() * sizeof(Vec)));
+        ASSERT_EQ(vecs.size(), inputIndex.size());
+        for(int i = 0; i < (int) inputIndex.size(); ++i){
+            ASSERT_EQ(vecs[inputIndex[i]].x, mesh.GetVerts()->at(i).x);
+            ASSERT_EQ(vecs[inputIndex[i]].y, mesh.GetVerts()->at(i).y);
+        }
+        vector<int> sorted = inputIndex;
+        sort(sorted.begin(), sorted.end());
+        for(int i = 0; i < (int) sorted.size(); ++i){
+            ASSERT_EQ(i, sorted[i]);
+        }
+
+        const Vec2d *verts = mesh.GetVerts()->data();
+        const HalfEdge *edges = mesh.GetEdges()->data();
+        Mesh::Generate(vecs.data(), vecs.size(), &mesh);
+        ASSERT_EQ(verts, mesh.GetVerts()->data());
+        ASSERT_EQ(edges, mesh.GetEdges()->data());
+        CheckDelaunay(mesh);
+    }
+}
+
+/**
+ * Regenerating a mesh of the same size reuses everything it has, also after Clear.
+ */
+TEST_F(MeshTest, RebuildDoesNotAllocate) {
+    vector<Vec> vecs;
+    for(int i = 0; i < 3000; ++i){
+        vecs.push_back(Vec(W * (static_cast<double>(rand()) / RAND_MAX), H * (static_cast<double>(rand()) / RAND_MAX)));
+    }
+    mesh->Rebuild(vecs.data(), vecs.size());
+    mesh->Clear();
+    ASSERT_EQ(0, mesh->GetNumFaces());
+    ASSERT_EQ(0, (int) mesh->GetVerts()->size());
+    for(int i = 0; i < 3; ++i){
+        for(Vec &v : vecs){
+            v = Vec(W * (static_cast<double>(rand()) / RAND_MAX), H * (static_cast<double>(rand()) / RAND_MAX));
+        }
+        const long before = numAllocations;
+        mesh->Rebuild(vecs.data(), vecs.size() - i, i == 1 ? InsertionOrder::RANDOM : InsertionOrder::BRIO);
+        ASSERT_EQ(before, numAllocations.load());
+        CheckDelaunay(*mesh);
+    }
+}
+
+/**
+ * Meshes on an arena take all their storage from it. Reset between them, it hands
+ * out the same block again, and building them no longer touches the heap.
+ */
+TEST_F(MeshTest, ArenaMeshesDoNotAllocate) {
+    Arena arena(1 << 12);
+    vector<Vec> vecs(2000);
+    for(int tile = 0; tile < 20; ++tile){
+        for(Vec &v : vecs){
+            v = Vec(W * (static_cast<double>(rand()) / RAND_MAX), H * (static_cast<double>(rand()) / RAND_MAX));
+        }
+        const long before = numAllocations;
+        {
+            Mesh tileMesh(&arena);
+            Mesh::Generate(vecs.data(), vecs.size() - tile, &tileMesh, NULL,
+                    tile % 2 ? InsertionOrder::RANDOM : InsertionOrder::BRIO);
+            tileMesh.Insert(Vec(2 * W, 2 * H));
+            tileMesh.Remove(tile);
+            ASSERT_EQ(&arena, tileMesh.GetResource());
+            ASSERT_EQ(&arena, tileMesh.GetEdges()->get_allocator().GetResource());
+            if (tile > 0) {
+                // The first tile grows the arena.
+                ASSERT_EQ(before, numAllocations.load());
+            }
+            CheckDelaunay(tileMesh);
+        }
+        arena.Reset();
+    }
 }
@@ -0,0 +1,159 @@
+/*
+ * PredicatesTest.cc
+ *
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include <Predicates.h>
+
+namespace {
+
+template <typename T>
+int Sign(T d) {
+    return (d > 0) - (d < 0);
+}
+
+/**
+ * Integer coordinates, so the determinants can be computed exactly with wide integers.
+ * Small coordinates give a lot of degenerate cases, large ones overflow the double mantissa.
+ */
+void CheckAgainstIntegers(int range) {
+    for (int i = 0; i < 20000; ++i) {
+        int64_t p[8];
+        for (int j = 0; j < 8; ++j) {
+            p[j] = rand() % range - range / 2;
+        }
+        const Vec a(p[0], p[1]), b(p[2], p[3]), c(p[4], p[5]), d(p[6], p[7]);
+
+        const int64_t orient = (p[0] - p[4]) * (p[3] - p[5]) - (p[1] - p[5]) * (p[2] - p[4]);
+        ASSERT_EQ(Sign(orient), Sign(Predicates::Orient2d(a, b, c)));
+
+        const __int128 adx = p[0] - p[6], ady = p[1] - p[7];
+        const __int128 bdx = p[2] - p[6], bdy = p[3] - p[7];
+        const __int128 cdx = p[4] - p[6], cdy = p[5] - p[7];
+        const __int128 incircle = (adx * adx + ady * ady) * (bdx * cdy - cdx * bdy)
+                + (bdx * bdx + bdy * bdy) * (cdx * ady - adx * cdy)
+                + (cdx * cdx + cdy * cdy) * (adx * bdy - bdx * ady);
+        ASSERT_EQ(Sign(incircle), Sign(Predicates::InCircle(a, b, c, d)));
+        // The filter alone may give up, but never with the wrong sign.
+        const double filtered = Predicates::InCircleFilter(Vec2d(a), Vec2d(b), Vec2d(c), Vec2d(d));
+        ASSERT_TRUE(filtered == 0 || Sign(filtered) == Sign(incircle));
+    }
+}
+
+TEST(PredicatesTest, SmallIntegers) {
+    CheckAgainstIntegers(8);
+}
+
+TEST(PredicatesTest, LargeIntegers) {
+    CheckAgainstIntegers(1 << 22);
+}
+
+/**
+ * Points a few ulps away from the line y = x. Plain doubles give orientations
+ * that change sign when the points are rotated.
+ */
+TEST(PredicatesTest, NearlyCollinear) {
+    const Vec b(12, 12), c(24, 24);
+    for (int i = 0; i < 64; ++i) {
+        for (int j = 0; j < 64; ++j) {
+            const Vec a(0.5 + i * ldexp(1.0, -53), 0.5 + j * ldexp(1.0, -53));
+            const int s = Sign(Predicates::Orient2d(a, b, c));
+            ASSERT_EQ(s, Sign(Predicates::Orient2d(b, c, a)));
+            ASSERT_EQ(s, Sign(Predicates::Orient2d(c, a, b)));
+            ASSERT_EQ(-s, Sign(Predicates::Orient2d(b, a, c)));
+            ASSERT_EQ(i == j ? 0 : (i < j ? 1 : -1), s);
+        }
+    }
+}
+
+/**
+ * Points on a large circle far from the origin, where the lifted coordinates round.
+ */
+TEST(PredicatesTest, Cocircular) {
+    const double k = 1 << 20, o = 1 << 30;
+    const Vec a(o + 3 * k, o + 4 * k), b(o - 4 * k, o + 3 * k), c(o - 5 * k, o), d(o + 4 * k, o - 3 * k);
+    ASSERT_EQ(0, Predicates::InCircle(a, b, c, d));
+    ASSERT_EQ(0, Predicates::InCircle(b, c, d, a));
+    ASSERT_LT(0, Predicates::InCircle(a, b, c, Vec(o, o)));
+    ASSERT_GT(0, Predicates::InCircle(a, b, c, Vec(o + 5 * k + 1, o)));
+}
+
+/**
+ * The integer kernel has to agree with the exact double predicates up to INT_COORD_MAX,
+ * where its intermediate products are the largest.
+ */
+void CheckIntegerKernel(int64_t range) {
+    for (int i = 0; i < 20000; ++i) {
+        Vec2i p[4];
+        for (int j = 0; j < 4; ++j) {
+            const int64_t r = ((int64_t) rand() << 31 | rand()) % (2 * range + 1);
+            const int64_t s = ((int64_t) rand() << 31 | rand()) % (2 * range + 1);
+            p[j] = Vec2i(r - range, s - range);
+        }
+        const Vec2d a(p[0]), b(p[1]), c(p[2]), d(p[3]);
+        ASSERT_EQ(Sign(Predicates::Orient2d(a, b, c)), Sign(Predicates::Orient2d(p[0], p[1], p[2])));
+        ASSERT_EQ(Sign(Predicates::InCircle(a, b, c, d)), Sign(Predicates::InCircle(p[0], p[1], p[2], p[3])));
+    }
+}
+
+TEST(PredicatesTest, IntegerKernel) {
+    CheckIntegerKernel(4);
+    CheckIntegerKernel(Predicates::INT_COORD_MAX);
+    // The corners of the allowed square, where every difference is as large as it gets.
+    const int32_t m = Predicates::INT_COORD_MAX;
+    const Vec2i a(m, -m), b(m, m), c(-m, m), d(-m, -m);
+    ASSERT_EQ(0, Predicates::InCircle(a, b, c, d));
+    ASSERT_LT(0, Predicates::InCircle(a, b, c, Vec2i(0, 0)));
+    ASSERT_LT(0, Predicates::InCircle(a, b, c, Vec2i(-m, -m + 1)));
+    ASSERT_GT(0, Predicates::InCircle(a, b, Vec2i(-m, -m + 1), c));
+    ASSERT_LT(0, Predicates::Orient2d(a, b, c));
+    ASSERT_EQ(0, Predicates::Orient2d(a, Vec2i(0, 0), c));
+}
+
+/**
+ * Cocircular quads abcd get a consistent answer: if d is inside the circle of abc, ac
+ * has to go, so b is inside the circle of cda and the diagonal bd is kept.
+ */
+template<class P>
+void CheckPerturbed(const P &a, const P &b, const P &c, const P &d) {
+    ASSERT_EQ(0, Sign(Predicates::InCircle(a, b, c, d)));
+    const int s = Sign(Predicates::InCirclePerturbed(a, b, c, d));
+    ASSERT_NE(0, s);
+    ASSERT_EQ(-s, Sign(Predicates::InCirclePerturbed(a, b, d, c)));
+    ASSERT_EQ(s, Sign(Predicates::InCirclePerturbed(c, d, a, b)));
+    ASSERT_EQ(-s, Sign(Predicates::InCirclePerturbed(b, c, d, a)));
+}
+
+TEST(PredicatesTest, Perturbed) {
+    // Every rotation of a square, and of a kite whose corners are on one circle.
+    const Vec2i square[4] = { Vec2i(0, 0), Vec2i(1, 0), Vec2i(1, 1), Vec2i(0, 1) };
+    const Vec2i kite[4] = { Vec2i(5, 0), Vec2i(3, 4), Vec2i(-5, 0), Vec2i(4, -3) };
+    for (int r = 0; r < 4; ++r) {
+        CheckPerturbed(square[r], square[(r + 1) % 4], square[(r + 2) % 4], square[(r + 3) % 4]);
+        const Vec2d k[4] = { Vec2d(kite[r]), Vec2d(kite[(r + 1) % 4]), Vec2d(kite[(r + 2) % 4]),
+                Vec2d(kite[(r + 3) % 4]) };
+        CheckPerturbed(k[0], k[1], k[2], k[3]);
+    }
+    // Points off the circle are not perturbed.
+    const Vec2i a(0, 0), b(4, 0), c(4, 4);
+    ASSERT_EQ(Predicates::InCircle(a, b, c, Vec2i(1, 2)), Predicates::InCirclePerturbed(a, b, c, Vec2i(1, 2)));
+    ASSERT_EQ(Predicates::InCircle(a, b, c, Vec2i(5, 5)), Predicates::InCirclePerturbed(a, b, c, Vec2i(5, 5)));
+}
+
+}
@@ -0,0 +1,66 @@
+/*
+ * SpatialSortTest.cc
+ *
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include <SpatialSort.h>
+
+namespace {
+
+/**
+ * Consecutive keys along the curve have to be neighbouring cells.
+ */
+TEST(SpatialSortTest, HilbertKeyIsContinuous) {
+    const uint32_t n = 64;
+    vector<pair<uint32_t, pair<int, int> > > cells;
+    for (uint32_t x = 0; x < n; ++x) {
+        for (uint32_t y = 0; y < n; ++y) {
+            cells.push_back(make_pair(SpatialSort::HilbertKey(x, y), make_pair(x, y)));
+        }
+    }
+    sort(cells.begin(), cells.end());
+    for (int i = 1; i < (int) cells.size(); ++i) {
+        ASSERT_EQ(cells[i - 1].first + 1, cells[i].first);
+        const int dx = abs(cells[i].second.first - cells[i - 1].second.first);
+        const int dy = abs(cells[i].second.second - cells[i - 1].second.second);
+        ASSERT_EQ(1, dx + dy);
+    }
+}
+
+/**
+ * BRIO only reorders, it never loses or duplicates points.
+ */
+TEST(SpatialSortTest, BrioIsPermutation) {
+    vector<Vec> verts;
+    for (int i = 0; i < 5000; ++i) {
+        verts.push_back(Vec(i % 71, i));
+    }
+    vector<Vec> sorted = verts;
+    SpatialSort::BrioSort(&sorted);
+    ASSERT_EQ(verts.size(), sorted.size());
+    vector<double> a, b;
+    for (int i = 0; i < (int) verts.size(); ++i) {
+        a.push_back(verts[i].y);
+        b.push_back(sorted[i].y);
+    }
+    sort(b.begin(), b.end());
+    ASSERT_TRUE(a == b);
+}
+
+}
@@ -0,0 +1,76 @@
+/*
+ * TraceTest.cc
+ *
+ *
+ *  This file is part of Delaunay.
+ *
+ *  Delaunay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Delaunay is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Delaunay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include <Mesh.h>
+#include <Trace.h>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+string Record(void (*run)()) {
+    Trace::Start();
+    run();
+    Trace::Stop();
+    const char *path = "trace_test.json";
+    EXPECT_TRUE(Trace::Write(path));
+    ifstream in(path);
+    stringstream text;
+    text << in.rdbuf();
+    remove(path);
+    return text.str();
+}
+
+void Generate() {
+    vector<Vec> vecs;
+    for(int i = 0; i < 1000; ++i){
+        vecs.push_back(Vec(rand() % 1000, rand() % 1000));
+    }
+    Mesh::Generate(vecs);
+    Mesh::GenerateDivideAndConquer(vecs);
+}
+
+/**
+ * The phases of both generators end up in the trace, as complete events.
+ */
+TEST(TraceTest, RecordsPhases) {
+    const string json = Record(Generate);
+    ASSERT_EQ(0u, json.find("{\"displayTimeUnit\""));
+    const char *phases[] = { "\"Generate\"", "\"BrioSort\"", "\"Triangulate\"", "\"InsertLoop\"",
+            "\"GenerateDivideAndConquer\"", "\"Sort\"", "\"Recurse\"", "\"Export\"" };
+    for (const char *phase : phases) {
+        ASSERT_NE(string::npos, json.find(phase)) << phase;
+    }
+    ASSERT_NE(string::npos, json.find("\"ph\": \"X\""));
+}
+
+/**
+ * Nothing is kept while the trace is not recording.
+ */
+TEST(TraceTest, StoppedRecordsNothing) {
+    Trace::Start();
+    Trace::Stop();
+    Generate();
+    const string json = Record([]() {});
+    ASSERT_EQ(string::npos, json.find("\"Generate\""));
+}
+
+}